@@ -0,0 +1,91 @@
+#include <lua/lexer.hpp>
+#include <lua/parallel.hpp>
+#include <utils/bench.hpp>
+#include <utils/stream/fstream.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	const std::string_view snippet = R"lua(
+local function fibonacci_%(n, memo)
+	-- memoized fibonacci with a long comment follow-up
+	memo = memo or {}
+	if n <= 2 then return 1 end
+	if memo[n] ~= nil then return memo[n] end
+	local value = fibonacci_%(n - 1, memo) + fibonacci_%(n - 2, memo)
+	memo[n] = value // 1 | 0x0 ~ 0
+	return value
+end
+--[==[ generated block %
+	with [[nested]] brackets ]==]
+local config_% = { name = "entry\t%", ratio = 3.14159e-2, mask = 0xFF00, [[
+long string value
+]], path = 'C:\\data\\%.lua' }
+for i = 1, #config_% do config_%[i] = config_%[i] .. "..." end
+)lua";
+
+	utils::buffer::owner<const std::byte> corpus(std::size_t size)
+	{
+		std::vector<std::byte> result;
+		result.reserve(size + snippet.size() * 2);
+		for(std::size_t block = 0; result.size() < size; ++block) {
+			const auto id = std::to_string(block);
+			for(char symbol: snippet) {
+				if(symbol == '%')
+					result.insert(result.end(), reinterpret_cast<const std::byte*>(id.data()), reinterpret_cast<const std::byte*>(id.data() + id.size()));
+				else
+					result.push_back(static_cast<std::byte>(symbol));
+			}
+		}
+		return result;
+	}
+
+	template<class Lexer>
+	std::size_t count(Lexer&& lexer)
+	{
+		std::size_t tokens = 0;
+		while(lexer.closed()) {
+			lexer.get();
+			++tokens;
+		}
+		return tokens;
+	}
+
+	utils::buffer::owner<const std::byte> load(const std::filesystem::path& path)
+	{
+		utils::stream::ifstream file(path);
+		return file.get(std::numeric_limits<std::size_t>::max());
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	utils::bench::suite suite("lexer", argc, argv);
+	const auto& arguments = suite.arguments();
+	const std::string argument = arguments.size() > 0 ? arguments[0] : "16";
+	const auto source = std::filesystem::is_regular_file(argument) ? load(argument) : corpus(std::strtoul(argument.c_str(), nullptr, 10) * 1024u * 1024u);
+	const std::size_t threads = arguments.size() > 1 ? std::strtoul(arguments[1].c_str(), nullptr, 10) : std::thread::hardware_concurrency();
+
+	suite.run("lexer/newlines", source.size(), utils::bench::unit::bytes, [&] {
+		return utils::bench::newlines(source.data(), source.size());
+	});
+	suite.run("lexer/serial", source.size(), utils::bench::unit::bytes, [&] {
+		return count(lua::lexer(source.share()));
+	});
+	suite.run("lexer/parallel", source.size(), utils::bench::unit::bytes, [&] {
+		return count(lua::parallel_lexer(source.share(), threads));
+	});
+	suite.run("lexer/positions", source.size(), utils::bench::unit::bytes, [&] {
+		lua::lexer lexer(source.share());
+		return lexer.position(source.size()).line;
+	});
+	suite.compare("lexer/serial", "lexer/newlines");
+	suite.compare("lexer/parallel", "lexer/newlines");
+	suite.compare("lexer/positions", "lexer/newlines");
+	return suite.finish();
+}
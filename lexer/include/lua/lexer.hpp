@@ -1,50 +1,163 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utils/buffer.hpp>
+#include <utils/stream/lines.hpp>
 
 namespace lua {
-	class token
+
+	inline constexpr std::array<std::string_view, 22> keywords = {
+		"and", "break", "do", "else", "elseif", "end", "false", "for", "function", "goto", "if",
+		"in", "local", "nil", "not", "or", "repeat", "return", "then", "true", "until", "while"
+	};
+
+	inline constexpr std::array<std::string_view, 33> operators = {
+		"...", "..", ".", "::", ":", "==", "=", "~=", "~", "<<", "<=", "<", ">>", ">=", ">", "//", "/",
+		"+", "-", "*", "%", "^", "#", "&", "|", "(", ")", "{", "}", "[", "]", ";", ","
+	};
+
+	enum class token_kind: std::uint8_t
 	{
-	public:
-		template<class T> class tag {};
-		inline static const tag<std::string> string;
-		inline static const tag<int> integer;
-		constexpr const auto& operator[](std::string_view value) const
+		eof, name, integer, number, string,
+		kw_and, kw_break, kw_do, kw_else, kw_elseif, kw_end, kw_false, kw_for, kw_function, kw_goto, kw_if,
+		kw_in, kw_local, kw_nil, kw_not, kw_or, kw_repeat, kw_return, kw_then, kw_true, kw_until, kw_while,
+		op_dots, op_concat, op_dot, op_label, op_colon, op_eq, op_assign, op_ne, op_bnot, op_shl, op_le, op_lt, op_shr, op_ge, op_gt, op_idiv, op_div,
+		op_add, op_sub, op_mul, op_mod, op_pow, op_len, op_band, op_bor, op_lparen, op_rparen, op_lbrace, op_rbrace, op_lbracket, op_rbracket, op_semicolon, op_comma
+	};
+
+	constexpr token_kind keyword_kind(std::size_t index) noexcept
+	{
+		return static_cast<token_kind>(static_cast<std::size_t>(token_kind::kw_and) + index);
+	}
+
+	constexpr token_kind operator_kind(std::size_t index) noexcept
+	{
+		return static_cast<token_kind>(static_cast<std::size_t>(token_kind::op_dots) + index);
+	}
+
+	namespace details
+	{
+		constexpr std::uint32_t keyword_key(std::string_view text) noexcept
 		{
-			return string;
+			return static_cast<std::uint8_t>(text.front()) | static_cast<std::uint32_t>(static_cast<std::uint8_t>(text.back())) << 8 | static_cast<std::uint32_t>(text.size()) << 16;
 		}
-	public:
-		class value
+
+		class keyword_table
 		{
-			
+		public:
+			static constexpr std::size_t bits = 6;
+			static constexpr std::size_t min_size = 2;
+			static constexpr std::size_t max_size = 8;
+		private:
+			std::array<std::uint8_t, std::size_t(1) << bits> slots{};
+			std::uint32_t seed = 0;
+		private:
+			constexpr bool place(std::uint32_t candidate) noexcept
+			{
+				slots = {};
+				for(std::size_t i = 0; i < keywords.size(); ++i) {
+					auto& slot = slots[hash(keywords[i], candidate)];
+					if(slot)
+						return false;
+					slot = static_cast<std::uint8_t>(i + 1);
+				}
+				seed = candidate;
+				return true;
+			}
+			static constexpr std::size_t hash(std::string_view text, std::uint32_t seed) noexcept
+			{
+				return static_cast<std::uint32_t>(keyword_key(text) * seed) >> (32 - bits);
+			}
+		public:
+			constexpr keyword_table() noexcept
+			{
+				for(std::uint32_t candidate = 0x9E3779B1u; !place(candidate); candidate += 2)
+					;
+			}
+		public:
+			constexpr std::size_t find(std::string_view text) const noexcept
+			{
+				if(text.size() < min_size || text.size() > max_size)
+					return keywords.size();
+				const auto slot = slots[hash(text, seed)];
+				if(slot && keywords[slot - 1] == text)
+					return slot - 1;
+				return keywords.size();
+			}
 		};
-	};
-	inline const token token;
 
-	class lexer
+		inline constexpr keyword_table keyword_index{};
+	}
+
+	constexpr token_kind keyword(std::string_view text, token_kind otherwise = token_kind::name) noexcept
 	{
+		const auto index = details::keyword_index.find(text);
+		return index < keywords.size() ? keyword_kind(index) : otherwise;
+	}
+
+	class syntax_error: public std::runtime_error
+	{
+		std::size_t offset_;
 	public:
-		class iterator
-		{
-			
-		};
-		template<class T>
-		auto get(const token::tag<T>& tag)
+		syntax_error(const std::string& what, std::size_t offset)
+		: std::runtime_error(what + " at offset " + std::to_string(offset)), offset_(offset)
+		{}
+	public:
+		std::size_t offset() const noexcept
 		{
-			return T{};
+			return offset_;
 		}
 	};
 
-	namespace details::token {
-		class base
-		{
+	struct token
+	{
+		template<class T> class tag {};
+		inline static const tag<std::string> string;
+		inline static const tag<std::int64_t> integer;
+		inline static const tag<double> number;
+		inline static const tag<utils::buffer::owner<const std::byte>> slice;
 
-		};
+		std::size_t offset;
+		std::uint32_t length;
+		token_kind kind;
+	};
 
-		template<class T>
-		class typed: public base
+	class lexer
+	{
+		utils::buffer::owner<const std::byte> source;
+		std::size_t cursor = 0;
+		token current;
+		mutable std::unique_ptr<utils::stream::line_index> lines;
+	private:
+		const char* data() const noexcept;
+		token scan();
+	public:
+		explicit lexer(utils::buffer::owner<const std::byte> source, std::size_t position = 0);
+		explicit lexer(utils::buffer::view<const char> source);
+	public:
+		using value_type = token;
+		token get();
+		bool closed() const noexcept;
+		void close();
+	public:
+		const utils::buffer::owner<const std::byte>& buffer() const noexcept
 		{
-			
-		};
-	}
-}
\ No newline at end of file
+			return source;
+		}
+		std::string_view text(const token& token) const noexcept;
+		utils::stream::line_column position(std::size_t offset) const;
+		utils::stream::line_column position(const token& token) const
+		{
+			return position(token.offset);
+		}
+		std::string get(const token& token, const token::tag<std::string>&) const;
+		std::int64_t get(const token& token, const token::tag<std::int64_t>&) const;
+		double get(const token& token, const token::tag<double>&) const;
+		utils::buffer::owner<const std::byte> get(const token& token, const token::tag<utils::buffer::owner<const std::byte>>&) const;
+	};
+}
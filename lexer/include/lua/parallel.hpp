@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <lua/lexer.hpp>
+
+namespace lua {
+
+	class parallel_lexer
+	{
+		struct chunk
+		{
+			std::vector<token> tokens;
+			std::exception_ptr error;
+			bool ready = false;
+		};
+		lexer decoder;
+		std::size_t size;
+		std::size_t chunk_size;
+		std::size_t window;
+		std::vector<chunk> chunks;
+		std::mutex mutex;
+		std::condition_variable produced;
+		std::condition_variable consumed;
+		std::size_t next = 0;
+		std::size_t released = 0;
+		bool stopping = false;
+		std::vector<std::thread> workers;
+		std::vector<token> pending;
+		std::size_t cursor = 0;
+		std::optional<lexer> fixer;
+		std::size_t resume = 0;
+		token current;
+	private:
+		utils::buffer::owner<const std::byte> source() const noexcept;
+		void work();
+		chunk& wait(std::size_t index);
+		token scan();
+	public:
+		static constexpr std::size_t default_chunk_size = 4u * 1024u * 1024u;
+		explicit parallel_lexer(utils::buffer::owner<const std::byte> source, std::size_t threads = 0, std::size_t chunk_size = default_chunk_size);
+		parallel_lexer(const parallel_lexer&) = delete;
+		parallel_lexer& operator=(const parallel_lexer&) = delete;
+		~parallel_lexer();
+	public:
+		using value_type = token;
+		token get();
+		bool closed() const noexcept;
+		void close();
+	public:
+		std::string_view text(const token& token) const noexcept
+		{
+			return decoder.text(token);
+		}
+		utils::stream::line_column position(const token& token) const
+		{
+			return decoder.position(token);
+		}
+		template<class T>
+		T get(const token& token, const token::tag<T>& tag) const
+		{
+			return decoder.get(token, tag);
+		}
+	};
+}
@@ -0,0 +1,424 @@
+#include <lua/lexer.hpp>
+#include <utils/regex/regular.hpp>
+#include <algorithm>
+#include <system_error>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+	const auto& match = utils::match;
+
+	constexpr auto letter = match('a', 'z') | match('A', 'Z') | match("_");
+	constexpr auto digit = match('0', '9');
+	constexpr auto hexdigit = match('0', '9') | match('a', 'f') | match('A', 'F');
+	constexpr auto space = match[" \t\r\n\v\f"];
+	constexpr auto spaces = +space;
+
+	constexpr auto name = letter & *(letter | digit);
+	constexpr auto decimal = ((+digit & !(match(".") & *digit)) | (match(".") & +digit)) & !(match["eE"] & !match["+-"] & +digit);
+	constexpr auto hexadecimal = match("0") & match["xX"] & ((+hexdigit & !(match(".") & *hexdigit)) | (match(".") & +hexdigit)) & !(match["pP"] & !match["+-"] & +digit);
+	constexpr auto numeral = hexadecimal | decimal;
+
+	constexpr auto anybyte = match('\0', '\x7f') | match('\x80', '\xff');
+	constexpr auto escape = (match("\\z") & *space) | (match("\\") & anybyte);
+	constexpr auto dqtext = match('\x80', '\xff') | match('\0', '\t') | match('\v', '\f') | match('\x0e', '!') | match('#', '[') | match(']', '\x7f');
+	constexpr auto sqtext = match('\x80', '\xff') | match('\0', '\t') | match('\v', '\f') | match('\x0e', '&') | match('(', '[') | match(']', '\x7f');
+	constexpr auto string = (match("\"") & *(+dqtext | escape) & match("\"")) | (match("'") & *(+sqtext | escape) & match("'"));
+
+	constexpr auto symbol = utils::literals("...", "..", ".", "::", ":", "==", "=", "~=", "~", "<<", "<=", "<", ">>", ">=", ">", "//", "/",
+		"+", "-", "*", "%", "^", "#", "&", "|", "(", ")", "{", "}", "[", "]", ";", ",");
+	static_assert(symbol.size() == lua::operators.size());
+
+	constexpr auto name_first = utils::lookahead(name).bytes;
+	constexpr auto numeral_first = utils::lookahead(numeral).bytes;
+	constexpr auto string_first = utils::lookahead(string).bytes;
+
+	struct decoded: utils::buffer::Resource<const std::byte>
+	{
+		std::string value;
+	public:
+		explicit decoded(std::string&& value) noexcept
+		: value(std::move(value))
+		{}
+	public:
+		const std::byte* begin() const noexcept override
+		{
+			return reinterpret_cast<const std::byte*>(value.data());
+		}
+		const std::byte* end() const noexcept override
+		{
+			return reinterpret_cast<const std::byte*>(value.data() + value.size());
+		}
+	};
+
+	[[noreturn]] void error(const char* what, std::size_t offset)
+	{
+		throw lua::syntax_error(what, offset);
+	}
+
+	std::size_t bracket_level(const char* begin, const char* end) noexcept
+	{
+		const char* it = begin + 1;
+		while(it != end && *it == '=')
+			++it;
+		if(it == end || *it != '[')
+			return std::string_view::npos;
+		return it - begin - 1;
+	}
+
+	std::size_t long_bracket(const char* begin, const char* end, std::size_t offset)
+	{
+		const auto level = bracket_level(begin, end);
+		if(level == std::string_view::npos)
+			return 0;
+		for(const char* it = begin + level + 2;;) {
+			it = static_cast<const char*>(std::memchr(it, ']', end - it));
+			if(!it)
+				error("unfinished long string or comment", offset);
+			const char* close = it + 1;
+			while(close != end && *close == '=')
+				++close;
+			if(close != end && *close == ']' && std::size_t(close - it - 1) == level)
+				return close + 1 - begin;
+			it = close;
+		}
+	}
+
+	bool is_alnum(char symbol) noexcept
+	{
+		return (symbol >= 'a' && symbol <= 'z') || (symbol >= 'A' && symbol <= 'Z') || (symbol >= '0' && symbol <= '9') || symbol == '_';
+	}
+
+	bool is_hex(std::string_view text) noexcept
+	{
+		return text.size() > 1 && (text[1] == 'x' || text[1] == 'X');
+	}
+
+	lua::token_kind numeral_kind(std::string_view text) noexcept
+	{
+		const bool hex = is_hex(text);
+		for(char symbol: text) {
+			if(symbol == '.')
+				return lua::token_kind::number;
+			if(!hex && (symbol == 'e' || symbol == 'E'))
+				return lua::token_kind::number;
+			if(hex && (symbol == 'p' || symbol == 'P'))
+				return lua::token_kind::number;
+		}
+		if(!hex) {
+			std::int64_t value = 0;
+			if(std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc::result_out_of_range)
+				return lua::token_kind::number;
+		}
+		return lua::token_kind::integer;
+	}
+
+	int hex_value(char symbol) noexcept
+	{
+		if(symbol >= '0' && symbol <= '9')
+			return symbol - '0';
+		if(symbol >= 'a' && symbol <= 'f')
+			return symbol - 'a' + 10;
+		if(symbol >= 'A' && symbol <= 'F')
+			return symbol - 'A' + 10;
+		return -1;
+	}
+
+	void append_utf8(std::string& result, std::uint32_t code)
+	{
+		if(code < 0x80) {
+			result += static_cast<char>(code);
+			return;
+		}
+		char buffer[6];
+		std::size_t size = 0;
+		std::uint32_t limit = 0x3f;
+		do {
+			buffer[5 - size++] = static_cast<char>(0x80 | (code & 0x3f));
+			code >>= 6;
+			limit >>= 1;
+		} while(code > limit);
+		buffer[5 - size] = static_cast<char>((~limit << 1) | code);
+		result.append(buffer + 5 - size, size + 1);
+	}
+
+	std::size_t long_prefix(std::string_view text) noexcept
+	{
+		const auto open = text.find('[', 1) + 1;
+		const auto close = text.size() - open;
+		if(open == close || (text[open] != '\n' && text[open] != '\r'))
+			return open;
+		const bool pair = open + 1 < close && (text[open + 1] == '\n' || text[open + 1] == '\r') && text[open + 1] != text[open];
+		return open + (pair ? 2 : 1);
+	}
+
+	std::string decode_long(std::string_view text)
+	{
+		const auto open = text.find('[', 1) + 1;
+		const auto prefix = long_prefix(text);
+		text = text.substr(prefix, text.size() - prefix - open);
+		std::string result;
+		result.reserve(text.size());
+		for(std::size_t i = 0; i < text.size(); ++i) {
+			if(text[i] == '\n' || text[i] == '\r') {
+				if(i + 1 < text.size() && (text[i + 1] == '\n' || text[i + 1] == '\r') && text[i + 1] != text[i])
+					++i;
+				result += '\n';
+			} else {
+				result += text[i];
+			}
+		}
+		return result;
+	}
+
+	std::string decode_short(std::string_view text, std::size_t offset)
+	{
+		text = text.substr(1, text.size() - 2);
+		std::string result;
+		result.reserve(text.size());
+		for(std::size_t i = 0; i < text.size(); ++i) {
+			if(text[i] != '\\') {
+				result += text[i];
+				continue;
+			}
+			const char symbol = text[++i];
+			switch(symbol) {
+				case 'a': result += '\a'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'v': result += '\v'; break;
+				case '\\': result += '\\'; break;
+				case '"': result += '"'; break;
+				case '\'': result += '\''; break;
+				case '\n': case '\r':
+					if(i + 1 < text.size() && (text[i + 1] == '\n' || text[i + 1] == '\r') && text[i + 1] != symbol)
+						++i;
+					result += '\n';
+					break;
+				case 'x': {
+					const int high = i + 1 < text.size() ? hex_value(text[i + 1]) : -1;
+					const int low = i + 2 < text.size() ? hex_value(text[i + 2]) : -1;
+					if(high < 0 || low < 0)
+						error("hexadecimal digit expected", offset + i + 1);
+					result += static_cast<char>(high * 16 + low);
+					i += 2;
+					break;
+				}
+				case 'z':
+					while(i + 1 < text.size() && std::strchr(" \t\r\n\v\f", text[i + 1]) && text[i + 1] != '\0')
+						++i;
+					break;
+				case 'u': {
+					if(i + 1 >= text.size() || text[i + 1] != '{')
+						error("missing '{' in \\u{xxxx}", offset + i + 1);
+					std::uint32_t code = 0;
+					std::size_t digits = 0;
+					for(i += 2; i < text.size() && hex_value(text[i]) >= 0; ++i, ++digits) {
+						if(code >= 0x8000000u)
+							error("UTF-8 value too large", offset + i + 1);
+						code = code * 16 + hex_value(text[i]);
+					}
+					if(!digits || i >= text.size() || text[i] != '}')
+						error("malformed \\u{xxxx} escape", offset + i + 1);
+					append_utf8(result, code);
+					break;
+				}
+				default: {
+					if(symbol < '0' || symbol > '9')
+						error("invalid escape sequence", offset + i + 1);
+					unsigned code = 0;
+					for(std::size_t digits = 0; digits < 3 && i < text.size() && text[i] >= '0' && text[i] <= '9'; ++digits, ++i)
+						code = code * 10 + (text[i] - '0');
+					if(code > 0xff)
+						error("decimal escape too large", offset + i + 1);
+					result += static_cast<char>(code);
+					--i;
+				}
+			}
+		}
+		return result;
+	}
+}
+
+namespace lua {
+
+	lexer::lexer(utils::buffer::owner<const std::byte> source, std::size_t position)
+	: source(std::move(source))
+	, cursor(std::min(position, this->source.size()))
+	, current(scan())
+	{}
+
+	lexer::lexer(utils::buffer::view<const char> source)
+	: lexer(utils::buffer::owner<const std::byte>(reinterpret_cast<const std::byte*>(source.begin()), reinterpret_cast<const std::byte*>(source.end())))
+	{}
+
+	const char* lexer::data() const noexcept
+	{
+		return reinterpret_cast<const char*>(source.data());
+	}
+
+	token lexer::scan()
+	{
+		const char* const data = this->data();
+		const char* const end = data + source.size();
+		const char* it = data + cursor;
+		for(;;) {
+			spaces.scan(it, end);
+			if(end - it < 2 || it[0] != '-' || it[1] != '-')
+				break;
+			if(const auto size = end - it > 2 && it[2] == '[' ? long_bracket(it + 2, end, it - data) : 0) {
+				it += size + 2;
+			} else {
+				const auto line = static_cast<const char*>(std::memchr(it, '\n', end - it));
+				it = line ? line : end;
+			}
+		}
+		cursor = it - data;
+		if(it == end)
+			return token{cursor, 0, token_kind::eof};
+
+		const char* longest = it;
+		auto kind = token_kind::eof;
+		const auto candidate = [&](const char* stop, token_kind rule) {
+			if(stop > longest) {
+				longest = stop;
+				kind = rule;
+			}
+		};
+		const auto byte = utils::regex_byte(*it);
+		if(name_first.test(byte)) {
+			const char* stop = it;
+			if(name.scan(stop, end))
+				candidate(stop, token_kind::name);
+		}
+		if(numeral_first.test(byte)) {
+			const char* stop = it;
+			if(numeral.scan(stop, end))
+				candidate(stop, token_kind::number);
+		}
+		if(string_first.test(byte)) {
+			const char* stop = it;
+			if(!string.scan(stop, end))
+				error("unfinished string", cursor);
+			candidate(stop, token_kind::string);
+		}
+		if(*it == '[') {
+			if(const auto size = long_bracket(it, end, cursor))
+				candidate(it + size, token_kind::string);
+			else if(end - it > 1 && it[1] == '=')
+				error("invalid long string delimiter", cursor);
+		}
+		{
+			const char* stop = it;
+			if(const auto result = symbol(stop, end))
+				candidate(stop, operator_kind(*result));
+		}
+		if(longest == it)
+			error("unexpected symbol", cursor);
+
+		const std::string_view text(it, longest - it);
+		if(kind == token_kind::name) {
+			kind = keyword(text);
+		} else if(kind == token_kind::number) {
+			if(longest != end && (is_alnum(*longest) || *longest == '.'))
+				error("malformed number", cursor);
+			kind = numeral_kind(text);
+		}
+		const token result{cursor, static_cast<std::uint32_t>(text.size()), kind};
+		cursor = longest - data;
+		return result;
+	}
+
+	token lexer::get()
+	{
+		const token result = current;
+		if(result.kind != token_kind::eof)
+			current = scan();
+		return result;
+	}
+
+	bool lexer::closed() const noexcept
+	{
+		return current.kind != token_kind::eof;
+	}
+
+	void lexer::close()
+	{
+		cursor = source.size();
+		current = token{cursor, 0, token_kind::eof};
+	}
+
+	std::string_view lexer::text(const token& token) const noexcept
+	{
+		return std::string_view(data() + token.offset, token.length);
+	}
+
+	utils::stream::line_column lexer::position(std::size_t offset) const
+	{
+		if(!lines) {
+			lines = std::make_unique<utils::stream::line_index>();
+			lines->add(source);
+		}
+		return lines->position(offset);
+	}
+
+	std::string lexer::get(const token& token, const token::tag<std::string>&) const
+	{
+		const auto value = text(token);
+		if(token.kind != token_kind::string)
+			return std::string(value);
+		if(value.front() == '[')
+			return decode_long(value);
+		return decode_short(value, token.offset);
+	}
+
+	std::int64_t lexer::get(const token& token, const token::tag<std::int64_t>&) const
+	{
+		if(token.kind != token_kind::integer)
+			throw std::system_error(make_error_code(std::errc::invalid_argument), "token is not an integer");
+		const auto value = text(token);
+		if(is_hex(value)) {
+			std::uint64_t result = 0;
+			for(char symbol: value.substr(2))
+				result = result * 16 + hex_value(symbol);
+			return static_cast<std::int64_t>(result);
+		}
+		std::int64_t result = 0;
+		std::from_chars(value.data(), value.data() + value.size(), result);
+		return result;
+	}
+
+	double lexer::get(const token& token, const token::tag<double>&) const
+	{
+		if(token.kind == token_kind::integer)
+			return static_cast<double>(get(token, token::integer));
+		if(token.kind != token_kind::number)
+			throw std::system_error(make_error_code(std::errc::invalid_argument), "token is not a number");
+		return std::strtod(std::string(text(token)).c_str(), nullptr);
+	}
+
+	utils::buffer::owner<const std::byte> lexer::get(const token& token, const token::tag<utils::buffer::owner<const std::byte>>&) const
+	{
+		if(token.kind != token_kind::string)
+			return source.slice(token.offset, token.length);
+		const auto value = text(token);
+		if(value.front() == '[') {
+			const auto open = value.find('[', 1) + 1;
+			const auto prefix = long_prefix(value);
+			const auto size = value.size() - prefix - open;
+			if(!std::memchr(value.data() + prefix, '\r', size))
+				return source.slice(token.offset + prefix, size);
+		} else if(!std::memchr(value.data() + 1, '\\', value.size() - 2)) {
+			return source.slice(token.offset + 1, value.size() - 2);
+		}
+		auto payload = get(token, token::string);
+		if(payload.size() <= utils::buffer::owner<const std::byte>::inline_capacity)
+			return utils::buffer::owner<const std::byte>::copy(reinterpret_cast<const std::byte*>(payload.data()), payload.size());
+		return utils::buffer::make<decoded>(std::move(payload));
+	}
+}
@@ -0,0 +1,139 @@
+#include <lua/parallel.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace lua {
+
+	parallel_lexer::parallel_lexer(utils::buffer::owner<const std::byte> source, std::size_t threads, std::size_t chunk_size)
+	: decoder(std::move(source), std::numeric_limits<std::size_t>::max())
+	, size(decoder.buffer().size())
+	, chunk_size(std::max<std::size_t>(chunk_size, 1))
+	{
+		if(!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		window = threads * 2;
+		chunks.resize((size + this->chunk_size - 1) / this->chunk_size);
+		threads = std::min(threads, chunks.size());
+		for(std::size_t i = 0; i < threads; ++i)
+			workers.emplace_back([this] { work(); });
+		try {
+			current = scan();
+		} catch(...) {
+			close();
+			throw;
+		}
+	}
+
+	parallel_lexer::~parallel_lexer()
+	{
+		close();
+	}
+
+	utils::buffer::owner<const std::byte> parallel_lexer::source() const noexcept
+	{
+		return decoder.buffer().slice(0, size);
+	}
+
+	void parallel_lexer::work()
+	{
+		for(;;) {
+			std::size_t index;
+			{
+				std::unique_lock lock(mutex);
+				consumed.wait(lock, [this] { return stopping || next >= chunks.size() || next < released + window; });
+				if(stopping || next >= chunks.size())
+					return;
+				index = next++;
+			}
+			const auto begin = index * chunk_size;
+			const auto end = std::min(begin + chunk_size, size);
+			std::vector<token> tokens;
+			std::exception_ptr error;
+			try {
+				lexer speculative(source(), begin);
+				while(speculative.closed()) {
+					const auto token = speculative.get();
+					if(token.offset >= end)
+						break;
+					tokens.push_back(token);
+				}
+			} catch(const syntax_error&) {
+				// A chunk may start inside a token; whatever follows is re-lexed by the fix-up pass.
+			} catch(...) {
+				error = std::current_exception();
+			}
+			{
+				std::lock_guard lock(mutex);
+				chunks[index].tokens = std::move(tokens);
+				chunks[index].error = error;
+				chunks[index].ready = true;
+			}
+			produced.notify_all();
+		}
+	}
+
+	parallel_lexer::chunk& parallel_lexer::wait(std::size_t index)
+	{
+		std::unique_lock lock(mutex);
+		if(released < index) {
+			for(; released < index; ++released)
+				std::vector<token>().swap(chunks[released].tokens);
+			consumed.notify_all();
+		}
+		produced.wait(lock, [this, index] { return chunks[index].ready; });
+		if(chunks[index].error)
+			std::rethrow_exception(chunks[index].error);
+		return chunks[index];
+	}
+
+	token parallel_lexer::scan()
+	{
+		if(cursor < pending.size()) {
+			const auto result = pending[cursor++];
+			resume = result.offset + result.length;
+			return result;
+		}
+		if(!fixer)
+			fixer.emplace(source(), resume);
+		if(!fixer->closed())
+			return token{size, 0, token_kind::eof};
+		const auto result = fixer->get();
+		resume = result.offset + result.length;
+		auto& speculative = wait(result.offset / chunk_size).tokens;
+		const auto found = std::lower_bound(speculative.begin(), speculative.end(), result.offset, [](const token& token, std::size_t offset) {
+			return token.offset < offset;
+		});
+		if(found != speculative.end() && found->offset == result.offset) {
+			cursor = found - speculative.begin() + 1;
+			pending = std::move(speculative);
+			fixer.reset();
+		}
+		return result;
+	}
+
+	token parallel_lexer::get()
+	{
+		const token result = current;
+		if(result.kind != token_kind::eof)
+			current = scan();
+		return result;
+	}
+
+	bool parallel_lexer::closed() const noexcept
+	{
+		return current.kind != token_kind::eof;
+	}
+
+	void parallel_lexer::close()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		consumed.notify_all();
+		for(auto& worker: workers)
+			worker.join();
+		workers.clear();
+		current = token{size, 0, token_kind::eof};
+	}
+}
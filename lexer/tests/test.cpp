@@ -1,32 +1,222 @@
-#include <boost/range/adaptor/filtered.hpp>
-#include <boost/fiber/all.hpp>
-#include <boost/assign.hpp>
-#include <iterator>
-#include <iostream>
+#include <catch2/catch_test_macros.hpp>
+
+#include <lua/lexer.hpp>
+#include <lua/parallel.hpp>
+#include <utils/channel/bounded.hpp>
+#include <thread>
+#include <tuple>
 #include <vector>
 
-typedef boost::fibers::buffered_channel< int > channel_t;
+namespace {
+
+	using lua::token_kind;
+
+	std::vector<token_kind> kinds(std::string_view source)
+	{
+		lua::lexer lexer(utils::buffer::view<const char>(source.data(), source.size()));
+		std::vector<token_kind> result;
+		while(lexer.closed())
+			result.push_back(lexer.get().kind);
+		return result;
+	}
+
+	std::vector<std::string> texts(std::string_view source)
+	{
+		lua::lexer lexer(utils::buffer::view<const char>(source.data(), source.size()));
+		std::vector<std::string> result;
+		while(lexer.closed())
+			result.emplace_back(lexer.text(lexer.get()));
+		return result;
+	}
+
+	template<class T>
+	T value(std::string_view source, const lua::token::tag<T>& tag)
+	{
+		lua::lexer lexer(utils::buffer::view<const char>(source.data(), source.size()));
+		return lexer.get(lexer.get(), tag);
+	}
+}
+
+TEST_CASE("lua lexer statements", "[lexer]")
+{
+	REQUIRE(kinds("local x = 10 -- comment\nreturn x") == std::vector<token_kind>{
+		token_kind::kw_local, token_kind::name, token_kind::op_assign, token_kind::integer,
+		token_kind::kw_return, token_kind::name
+	});
+	REQUIRE(texts("function t.a.b.c:f (params) body end") == std::vector<std::string>{
+		"function", "t", ".", "a", ".", "b", ".", "c", ":", "f", "(", "params", ")", "body", "end"
+	});
+	REQUIRE(texts("a...b..c.d::e: f//g/h<<i<=j<k>>l>=m>n==o~=p~q") == std::vector<std::string>{
+		"a", "...", "b", "..", "c", ".", "d", "::", "e", ":", "f", "//", "g", "/", "h", "<<", "i", "<=", "j", "<",
+		"k", ">>", "l", ">=", "m", ">", "n", "==", "o", "~=", "p", "~", "q"
+	});
+	REQUIRE(texts("t[ [[x]] ] = .5 --[==[ long\n]] comment ]==] elseif_ elseif") == std::vector<std::string>{
+		"t", "[", "[[x]]", "]", "=", ".5", "elseif_", "elseif"
+	});
+	REQUIRE(kinds("") == std::vector<token_kind>{});
+	REQUIRE(kinds("  \n\t-- only a comment") == std::vector<token_kind>{});
+}
+
+TEST_CASE("lua lexer token positions", "[lexer]")
+{
+	lua::lexer lexer(utils::buffer::view<const char>("local x = 1\n\n  return [[a\nb]] .. x", 34));
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> positions;
+	while(lexer.closed()) {
+		const auto position = lexer.position(lexer.get());
+		positions.emplace_back(position.line, position.column);
+	}
+	REQUIRE(positions == std::vector<std::pair<std::uint64_t, std::uint64_t>>{
+		{1, 1}, {1, 7}, {1, 9}, {1, 11}, {3, 3}, {3, 10}, {4, 5}, {4, 8}
+	});
+}
+
+TEST_CASE("lua lexer keyword hashing", "[lexer]")
+{
+	static_assert(lua::keyword("while") == token_kind::kw_while);
+	static_assert(lua::keyword("whilst") == token_kind::name);
+	for(std::size_t i = 0; i < lua::keywords.size(); ++i) {
+		REQUIRE(lua::keyword(lua::keywords[i]) == lua::keyword_kind(i));
+		REQUIRE(lua::keyword(std::string(lua::keywords[i]) + "_") == token_kind::name);
+	}
+	for(auto source: {"", "x", "And", "functions", "ends", "nill", "rep", "thenn"})
+		REQUIRE(lua::keyword(source) == token_kind::name);
+}
 
-void send( channel_t & chan) {
-    for ( int i = 0; i < 5; ++i) {
-        chan.push( i);
-    }
-    chan.close();
+TEST_CASE("lua lexer numerals", "[lexer]")
+{
+	for(auto source: {"3", "345", "0xff", "0xBEBADA", "9223372036854775807"})
+		REQUIRE(kinds(source) == std::vector<token_kind>{token_kind::integer});
+	for(auto source: {"3.0", "3.1416", "314.16e-2", "0.31416E1", "34e1", "0x0.1E", "0xA23p-4", "0X1.921FB54442D18P+1", "3.", ".3", "9223372036854775808"})
+		REQUIRE(kinds(source) == std::vector<token_kind>{token_kind::number});
+	REQUIRE(value("345", lua::token::integer) == 345);
+	REQUIRE(value("0xff", lua::token::integer) == 255);
+	REQUIRE(value("0xffffffffffffffff", lua::token::integer) == -1);
+	REQUIRE(value("314.16e-2", lua::token::number) == 3.1416);
+	REQUIRE(value("0xA23p-4", lua::token::number) == 162.1875);
+	REQUIRE_THROWS_AS(kinds("3x"), lua::syntax_error);
+	REQUIRE_THROWS_AS(kinds("1..2"), lua::syntax_error);
+	REQUIRE_THROWS_AS(kinds("0x"), lua::syntax_error);
 }
 
-void recv( channel_t & chan) {
-    int i;
-    while ( boost::fibers::channel_op_status::success == chan.pop(i) ) {
-        std::cout << "received " << i << std::endl;
-    }
+TEST_CASE("lua lexer strings", "[lexer]")
+{
+	REQUIRE(value(R"("alo\n123\"")", lua::token::string) == "alo\n123\"");
+	REQUIRE(value(R"('\97lo\10\04923"')", lua::token::string) == "alo\n123\"");
+	REQUIRE(value(R"("\x41\u{48}\u{20AC}\z
+	      tail")", lua::token::string) == "AH\xE2\x82\xACtail");
+	REQUIRE(value("[[\nalo\n123\"]]", lua::token::string) == "alo\n123\"");
+	REQUIRE(value("[==[\r\nalo\r\n123\"]]]==]", lua::token::string) == "alo\n123\"]]");
+	REQUIRE(value("name", lua::token::string) == "name");
+	for(unsigned byte = 0; byte < 256; ++byte) {
+		const char escaped[] = {'"', '\\', static_cast<char>(byte), '"'};
+		REQUIRE(kinds(std::string_view(escaped, sizeof(escaped))) == std::vector<token_kind>{token_kind::string});
+	}
+	REQUIRE_THROWS_AS(kinds("\"unfinished\nstring\""), lua::syntax_error);
+	REQUIRE_THROWS_AS(kinds("[==[ unfinished ]=]"), lua::syntax_error);
+	REQUIRE_THROWS_AS(kinds("[= x"), lua::syntax_error);
+	REQUIRE_THROWS_AS(value(R"("\q")", lua::token::string), lua::syntax_error);
+	REQUIRE_THROWS_AS(kinds("a $ b"), lua::syntax_error);
+	try {
+		kinds("a $ b");
+		FAIL("no syntax error");
+	} catch(const lua::syntax_error& error) {
+		REQUIRE(error.offset() == 2);
+		REQUIRE(std::string_view(error.what()) == "unexpected symbol at offset 2");
+	}
 }
 
-int main(int argc, const char* argv[])
+TEST_CASE("lua lexer payload slices", "[lexer]")
 {
-	channel_t chan{ 2 };
-	boost::fibers::fiber f1( std::bind( send, std::ref( chan) ) );
-	boost::fibers::fiber f2( std::bind( recv, std::ref( chan) ) );
+	const std::string_view text = "name 0x1F 'plain' \"esc\\n\" [==[\nlong]]]==] [[\r\nline\r\n]]";
+	std::vector<lua::token> tokens;
+	utils::buffer::owner<const std::byte> name;
+	{
+		lua::lexer lexer(utils::buffer::owner<const std::byte>(std::vector<std::byte>(
+			reinterpret_cast<const std::byte*>(text.data()), reinterpret_cast<const std::byte*>(text.data() + text.size()))));
+		const auto source = lexer.get(lua::token{0, static_cast<std::uint32_t>(text.size()), token_kind::name}, lua::token::slice);
+		const auto shared = [&source](const utils::buffer::view<const std::byte>& payload) {
+			return payload.begin() >= source.begin() && payload.end() <= source.end();
+		};
+		const auto slice = [&lexer](lua::token token) {
+			auto payload = lexer.get(token, lua::token::slice);
+			return std::pair(std::string(reinterpret_cast<const char*>(payload.data()), payload.size()), std::move(payload));
+		};
+		while(lexer.closed())
+			tokens.push_back(lexer.get());
+		REQUIRE(tokens.size() == 6);
 
-	f1.join();
-	f2.join();
-}
\ No newline at end of file
+		auto [value, payload] = slice(tokens[0]);
+		REQUIRE(value == "name");
+		REQUIRE(shared(payload));
+		name = std::move(payload);
+		REQUIRE(slice(tokens[1]).first == "0x1F");
+		REQUIRE(shared(slice(tokens[1]).second));
+		REQUIRE(slice(tokens[2]).first == "plain");
+		REQUIRE(shared(slice(tokens[2]).second));
+		REQUIRE(slice(tokens[3]).first == "esc\n");
+		REQUIRE(!shared(slice(tokens[3]).second));
+		REQUIRE(slice(tokens[4]).first == "long]]");
+		REQUIRE(shared(slice(tokens[4]).second));
+		REQUIRE(slice(tokens[5]).first == "line\n");
+		REQUIRE(!shared(slice(tokens[5]).second));
+	}
+	REQUIRE(std::string_view(reinterpret_cast<const char*>(name.data()), name.size()) == "name");
+}
+
+TEST_CASE("lua lexer in parallel chunks", "[lexer]")
+{
+	std::string text;
+	for(int i = 0; i < 200; ++i) {
+		text += "local v" + std::to_string(i) + " = { 0x" + std::to_string(i) + ", 3.5e-" + std::to_string(i % 9) + ", 'q\\'s', \"a $ b\" }\n";
+		text += "--[==[ long comment " + std::to_string(i) + " with \"quotes\" and a = b ]] ]==]\n";
+		text += "s = [[ long string " + std::to_string(i) + " -- not a comment \n x ]]..v" + std::to_string(i) + " -- tail\n";
+	}
+	const auto owner = [&text] {
+		return utils::buffer::owner<const std::byte>(reinterpret_cast<const std::byte*>(text.data()), reinterpret_cast<const std::byte*>(text.data() + text.size()));
+	};
+	std::vector<std::tuple<std::size_t, std::uint32_t, token_kind>> expected;
+	for(lua::lexer lexer(owner()); lexer.closed(); ) {
+		const auto token = lexer.get();
+		expected.emplace_back(token.offset, token.length, token.kind);
+	}
+	for(std::size_t chunk: {1u, 7u, 64u, 1000u, 1u << 20}) {
+		for(std::size_t threads: {1u, 4u}) {
+			std::vector<std::tuple<std::size_t, std::uint32_t, token_kind>> tokens;
+			for(lua::parallel_lexer lexer(owner(), threads, chunk); lexer.closed(); ) {
+				const auto token = lexer.get();
+				tokens.emplace_back(token.offset, token.length, token.kind);
+			}
+			REQUIRE(tokens == expected);
+		}
+	}
+
+	lua::parallel_lexer lexer(owner(), 2, 16);
+	REQUIRE(lexer.text(lexer.get()) == "local");
+	REQUIRE(lexer.get(lexer.get(), lua::token::slice).size() == 2);
+	lexer.close();
+	REQUIRE(!lexer.closed());
+
+	text += "x = \"unfinished";
+	REQUIRE_THROWS_AS([&owner] {
+		for(lua::parallel_lexer lexer(owner(), 3, 32); lexer.closed(); )
+			lexer.get();
+	}(), lua::syntax_error);
+}
+
+TEST_CASE("lua lexer feeding a bounded channel", "[lexer]")
+{
+	const std::string_view source = "for i = 1, 10 do print(i) end";
+	auto [reader, writer] = utils::channel::spsc<lua::token>(8);
+	std::thread producer([writer = std::move(writer), source]() mutable {
+		lua::lexer lexer(utils::buffer::view<const char>(source.data(), source.size()));
+		while(lexer.closed())
+			writer.put(lexer.get());
+	});
+	std::size_t received = 0;
+	for(const auto& token: utils::channel::irange(std::move(reader))) {
+		REQUIRE(token.kind != token_kind::eof);
+		++received;
+	}
+	producer.join();
+	REQUIRE(received == 12);
+}
@@ -0,0 +1,231 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace utils::bench {
+
+	enum class unit { bytes, items };
+
+	struct result
+	{
+		std::string name;
+		unit measure = unit::bytes;
+		double value = 0;
+		std::uint64_t iterations = 0;
+		double seconds = 0;
+	public:
+		std::string_view units() const noexcept
+		{
+			return measure == unit::bytes ? "MiB/s" : "Mitems/s";
+		}
+	};
+
+	template<class T>
+	inline void keep(T&& value) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	// Counts the newlines in a block with memchr. Its speed follows the host
+	// rather than any code under test, which makes it a reference to compare
+	// headline results against.
+	inline std::size_t newlines(const void* data, std::size_t size) noexcept
+	{
+		std::size_t count = 0;
+		for(auto it = static_cast<const char*>(data), end = it + size; (it = static_cast<const char*>(std::memchr(it, '\n', end - it))); ++it)
+			++count;
+		return count;
+	}
+
+	// Baselines hold absolute numbers from whichever machine wrote them, so
+	// they are not compared directly. The gate only checks pairs registered
+	// with compare(): the ratio of two results from the same run must stay
+	// within the tolerance of the same ratio in the baseline. Headline results
+	// are paired with a calibration run such as newlines(), so that they fail
+	// the gate when they get slower on their own.
+	class suite
+	{
+		std::string title;
+		std::vector<std::string> positional;
+		std::string filter;
+		std::filesystem::path json;
+		std::filesystem::path baseline;
+		bool update = false;
+		double tolerance = 0.25;
+		std::chrono::duration<double> min_time{0.2};
+		std::size_t repeats = 5;
+		std::vector<result> results;
+		std::vector<std::pair<std::string, std::string>> ratios;
+	private:
+		static std::string quote(std::string_view text)
+		{
+			std::string quoted = "\"";
+			for(char symbol: text) {
+				if(symbol == '"' || symbol == '\\')
+					quoted += '\\';
+				quoted += symbol;
+			}
+			return quoted + '"';
+		}
+		static std::map<std::string, double> load(const std::filesystem::path& path)
+		{
+			std::ifstream file(path);
+			if(!file)
+				throw std::system_error(make_error_code(std::errc::no_such_file_or_directory), path.string());
+			std::stringstream text;
+			text << file.rdbuf();
+			const auto content = text.str();
+			const auto string = [&content](std::size_t at) {
+				const auto begin = content.find('"', content.find(':', at)) + 1;
+				return content.substr(begin, content.find('"', begin) - begin);
+			};
+			std::map<std::string, double> values;
+			for(auto at = content.find("\"name\""); at != std::string::npos; at = content.find("\"name\"", at + 1)) {
+				const auto value = content.find("\"value\"", at);
+				if(value == std::string::npos)
+					break;
+				values[string(at)] = std::strtod(content.c_str() + content.find(':', value) + 1, nullptr);
+			}
+			return values;
+		}
+		void write(const std::filesystem::path& path) const
+		{
+			if(path.has_parent_path())
+				std::filesystem::create_directories(path.parent_path());
+			std::ofstream file(path, std::ios::trunc);
+			file << "{\n\t\"suite\": " << quote(title) << ",\n\t\"results\": [";
+			for(std::size_t i = 0; i < results.size(); ++i) {
+				const auto& entry = results[i];
+				file << (i ? ",\n" : "\n") << "\t\t{\"name\": " << quote(entry.name) << ", \"unit\": " << quote(entry.units())
+					<< ", \"value\": " << std::setprecision(6) << entry.value << ", \"iterations\": " << entry.iterations
+					<< ", \"seconds\": " << entry.seconds << "}";
+			}
+			file << "\n\t]\n}\n";
+			if(!file)
+				throw std::system_error(make_error_code(std::errc::io_error), path.string());
+		}
+	public:
+		suite(std::string title, int argc, const char* argv[])
+		: title(std::move(title))
+		{
+			for(int i = 1; i < argc; ++i) {
+				const std::string_view argument = argv[i];
+				const auto parameter = [&]() -> std::string {
+					if(i + 1 >= argc)
+						throw std::system_error(make_error_code(std::errc::invalid_argument), std::string(argument));
+					return argv[++i];
+				};
+				if(argument == "--json")
+					json = parameter();
+				else if(argument == "--baseline")
+					baseline = parameter();
+				else if(argument == "--update")
+					update = true;
+				else if(argument == "--filter")
+					filter = parameter();
+				else if(argument == "--tolerance")
+					tolerance = std::strtod(parameter().c_str(), nullptr);
+				else if(argument == "--min-time")
+					min_time = std::chrono::duration<double>(std::strtod(parameter().c_str(), nullptr));
+				else if(argument == "--repeats")
+					repeats = std::max<std::size_t>(std::strtoul(parameter().c_str(), nullptr, 10), 1);
+				else
+					positional.emplace_back(argument);
+			}
+		}
+	public:
+		const std::vector<std::string>& arguments() const noexcept
+		{
+			return positional;
+		}
+		template<class Body>
+		void run(std::string name, std::uint64_t work, unit measure, Body&& body)
+		{
+			if(!filter.empty() && name.find(filter) == std::string::npos)
+				return;
+			using clock = std::chrono::steady_clock;
+			const auto sample = [&body](std::uint64_t iterations) {
+				const auto start = clock::now();
+				for(std::uint64_t i = 0; i < iterations; ++i)
+					keep(body());
+				return std::chrono::duration<double>(clock::now() - start).count();
+			};
+			std::uint64_t iterations = 1;
+			for(auto elapsed = sample(iterations); elapsed < min_time.count() / repeats; elapsed = sample(iterations))
+				iterations = elapsed > 0 ? std::max(iterations * 2, static_cast<std::uint64_t>(iterations * min_time.count() / repeats / elapsed)) : iterations * 2;
+			auto best = sample(iterations);
+			for(std::size_t i = 1; i < repeats; ++i)
+				best = std::min(best, sample(iterations));
+			const double scale = measure == unit::bytes ? 1024.0 * 1024.0 : 1e6;
+			auto& entry = results.emplace_back(result{std::move(name), measure, work * iterations / scale / best, iterations, best});
+			std::cout << std::left << std::setw(40) << entry.name << std::right << std::setw(12) << std::fixed << std::setprecision(2)
+				<< entry.value << ' ' << entry.units() << std::defaultfloat << std::endl;
+		}
+		void compare(std::string name, std::string reference)
+		{
+			ratios.emplace_back(std::move(name), std::move(reference));
+		}
+		const std::vector<result>& measured() const noexcept
+		{
+			return results;
+		}
+		int finish() const
+		{
+			if(!json.empty())
+				write(json);
+			if(baseline.empty())
+				return EXIT_SUCCESS;
+			if(update) {
+				write(baseline);
+				return EXIT_SUCCESS;
+			}
+			const auto expected = load(baseline);
+			const auto value = [this](const std::string& name) -> const result* {
+				const auto found = std::find_if(results.begin(), results.end(), [&name](const result& entry) {
+					return entry.name == name;
+				});
+				return found != results.end() ? &*found : nullptr;
+			};
+			for(const auto& entry: results)
+				if(!expected.count(entry.name))
+					std::cout << entry.name << ": no baseline" << std::endl;
+			int status = EXIT_SUCCESS;
+			for(const auto& [name, reference]: ratios) {
+				const auto* entry = value(name);
+				const auto* base = value(reference);
+				const auto previous = expected.find(name);
+				const auto previous_base = expected.find(reference);
+				if(!entry || !base || previous == expected.end() || previous_base == expected.end())
+					continue;
+				const double ratio = entry->value / base->value;
+				const double was = previous->second / previous_base->second;
+				if(ratio < was * (1 - tolerance)) {
+					std::cout << name << ": regressed to " << std::fixed << std::setprecision(2) << ratio << "x " << reference
+						<< " from " << was << 'x' << std::defaultfloat << std::endl;
+					status = EXIT_FAILURE;
+				}
+			}
+			return status;
+		}
+	};
+
+}
@@ -1,6 +1,14 @@
 #pragma once
-#include <utility>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace utils {
 
@@ -11,11 +19,169 @@ namespace utils {
 		template<class T>
 		struct Resource
 		{
+			mutable std::atomic<std::size_t> references{0};
+			bool local = false;
+		public:
+			Resource() = default;
+			Resource(const Resource&) = delete;
+			Resource& operator=(const Resource&) = delete;
+			virtual ~Resource() = default;
 			virtual T* begin() const noexcept = 0;
 			virtual T* end() const noexcept = 0;
+		public:
+			void acquire() const noexcept
+			{
+				if(local)
+					references.store(references.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				else
+					references.fetch_add(1, std::memory_order_relaxed);
+			}
+			void release() const noexcept
+			{
+				std::size_t previous;
+				if(local) {
+					previous = references.load(std::memory_order_relaxed);
+					references.store(previous - 1, std::memory_order_relaxed);
+				} else {
+					previous = references.fetch_sub(1, std::memory_order_acq_rel);
+				}
+				if(previous == 1)
+					delete this;
+			}
 		};
+		template<class R, class... Args>
+		static auto make(Args&&... args);
+		template<class R, class... Args>
+		static auto make_local(Args&&... args);
 	};
 
+	namespace details
+	{
+		inline constexpr std::size_t slab_limit = 256;
+
+		inline std::atomic<void*>& slab_chain() noexcept
+		{
+			static std::atomic<void*> head{nullptr};
+			return head;
+		}
+
+		template<std::size_t Size>
+		class slab
+		{
+			union block
+			{
+				block* next;
+				alignas(std::max_align_t) std::byte storage[Size];
+			};
+			static constexpr std::size_t count = 64;
+			// Blocks freed on another thread pile up in that thread's cache, so
+			// whole batches past the limit go back to a shared list that any
+			// thread can take from. The shared list is only pushed to or emptied
+			// in one go, which keeps it free of ABA.
+			struct cache
+			{
+				block* head = nullptr;
+				std::size_t size = 0;
+			public:
+				~cache()
+				{
+					give(head, size);
+					head = nullptr;
+					size = 0;
+				}
+			};
+			inline static std::atomic<block*> shared{nullptr};
+			inline static std::atomic<std::size_t> reserved_{0};
+			inline static thread_local cache local;
+		private:
+			static void give(block* head, std::size_t size) noexcept
+			{
+				if(!size)
+					return;
+				block* tail = head;
+				while(--size)
+					tail = tail->next;
+				block* top = shared.load(std::memory_order_relaxed);
+				do {
+					tail->next = top;
+				} while(!shared.compare_exchange_weak(top, head, std::memory_order_release, std::memory_order_relaxed));
+			}
+			static void refill()
+			{
+				if(auto* taken = shared.exchange(nullptr, std::memory_order_acquire)) {
+					local.head = taken;
+					for(local.size = 1; taken->next; ++local.size)
+						taken = taken->next;
+					return;
+				}
+				auto* blocks = new block[count + 1];
+				reserved_.fetch_add(count, std::memory_order_relaxed);
+				auto& chain = slab_chain();
+				void* head = chain.load(std::memory_order_relaxed);
+				do {
+					blocks->next = static_cast<block*>(head);
+				} while(!chain.compare_exchange_weak(head, blocks, std::memory_order_release, std::memory_order_relaxed));
+				for(std::size_t i = 1; i <= count; ++i)
+					release(blocks + i);
+			}
+		public:
+			static void* allocate()
+			{
+				if(!local.head)
+					refill();
+				auto* result = local.head;
+				local.head = result->next;
+				--local.size;
+				return result;
+			}
+			static void release(void* memory) noexcept
+			{
+				auto* released = static_cast<block*>(memory);
+				released->next = local.head;
+				local.head = released;
+				if(++local.size < 2 * count)
+					return;
+				block* batch = local.head;
+				for(std::size_t i = 0; i < count; ++i)
+					local.head = local.head->next;
+				local.size -= count;
+				give(batch, count);
+			}
+			static std::size_t reserved() noexcept
+			{
+				return reserved_.load(std::memory_order_relaxed);
+			}
+		};
+
+		template<class R>
+		struct pooled final: R
+		{
+			using slab_t = slab<(sizeof(R) + 15) / 16 * 16>;
+		public:
+			template<class... Args>
+			explicit pooled(Args&&... args)
+			: R(std::forward<Args>(args)...)
+			{}
+			static void* operator new(std::size_t)
+			{
+				return slab_t::allocate();
+			}
+			static void operator delete(void* memory) noexcept
+			{
+				slab_t::release(memory);
+			}
+		};
+
+		template<class R, class... Args>
+		auto* allocate_resource(Args&&... args)
+		{
+			if constexpr(sizeof(R) <= slab_limit && !std::is_final_v<R>)
+				return static_cast<R*>(new pooled<R>(std::forward<Args>(args)...));
+			else
+				return new R(std::forward<Args>(args)...);
+		}
+	}
+
 	template<class T>
 	class buffer::view
 	{
@@ -86,9 +252,15 @@ namespace utils {
 			end_ -= count;
 			return result;
 		}
+		view slice(std::size_t offset, std::size_t count) const noexcept
+		{
+			offset = std::min(offset, size());
+			count = std::min(count, size() - offset);
+			return view(data() + offset, count);
+		}
 		operator view<const T>() const noexcept
 		{
-			return view<const T>(*this);
+			return view<const T>(begin_, size());
 		}
 		friend bool operator==(const view& a, const view& b) noexcept
 		{
@@ -112,7 +284,11 @@ namespace utils {
 	template<class T>
 	class buffer::owner: public buffer::view<T>
 	{
+		friend struct buffer;
 		using base = buffer::view<T>;
+		using value_t = std::remove_const_t<T>;
+	public:
+		static constexpr std::size_t inline_capacity = std::is_trivial_v<value_t> ? 24 / sizeof(value_t) : 0;
 	private:
 		template<class Container>
 		struct ContainerResource: Resource<T>
@@ -130,17 +306,94 @@ namespace utils {
 			: container(std::move(container))
 			{}
 		};
-		std::shared_ptr<Resource<T>> resource = nullptr;
+		template<class R>
+		struct SharedResource: Resource<T>
+		{
+			std::shared_ptr<R> shared;
+			T* begin() const noexcept override
+			{
+				return shared->begin();
+			}
+			T* end() const noexcept override
+			{
+				return shared->end();
+			}
+			SharedResource(std::shared_ptr<R>&& shared) noexcept
+			: shared(std::move(shared))
+			{}
+		};
+		using storage_t = std::conditional_t<(inline_capacity > 0), std::array<value_t, std::max<std::size_t>(inline_capacity, 1)>, std::array<std::byte, sizeof(void*)>>;
+		union
+		{
+			Resource<T>* resource = nullptr;
+			storage_t storage;
+		};
+	private:
+		bool is_inline() const noexcept
+		{
+			if constexpr(inline_capacity > 0) {
+				const auto* first = reinterpret_cast<const value_t*>(storage.data());
+				return !std::less<const value_t*>()(base::data(), first) && !std::less<const value_t*>()(first + inline_capacity, base::data());
+			} else {
+				return false;
+			}
+		}
+		void assign(const value_t* data, std::size_t size) noexcept
+		{
+			if constexpr(inline_capacity > 0) {
+				std::copy(data, data + size, storage.data());
+				base::operator=(base(storage.data(), size));
+			}
+		}
+		void steal(owner& other) noexcept
+		{
+			if(other.is_inline()) {
+				assign(other.data(), other.size());
+				other.resource = nullptr;
+			} else {
+				resource = std::exchange(other.resource, nullptr);
+				base::operator=(other);
+			}
+			static_cast<base&>(other) = base();
+		}
+		void reset() noexcept
+		{
+			if(!is_inline() && resource)
+				resource->release();
+			resource = nullptr;
+			base::operator=(base());
+		}
+		owner share(base part) const noexcept
+		{
+			if(is_inline())
+				return owner::copy(part.data(), part.size());
+			return owner(resource, part);
+		}
+		owner(Resource<T>* resource, base view) noexcept
+		: base(view)
+		, resource(resource)
+		{
+			if(resource)
+				resource->acquire();
+		}
+		explicit owner(Resource<T>* resource) noexcept
+		: owner(resource, resource ? base(resource->begin(), resource->end() - resource->begin()) : base())
+		{}
+		template<class R>
+		static Resource<T>* wrap(std::shared_ptr<R>&& resource)
+		{
+			if(!resource)
+				return nullptr;
+			return details::allocate_resource<SharedResource<R>>(std::move(resource));
+		}
 	public:
 		template<class R>
-		owner(std::shared_ptr<R> resource) noexcept
-		: base(resource->begin(), resource->end())
-		, resource(std::move(resource))
+		owner(std::shared_ptr<R> resource)
+		: owner(wrap(std::move(resource)))
 		{}
 		template<class R>
-		owner(std::shared_ptr<R> resource, buffer::view<T> view) noexcept
-		: base(view)
-		, resource(std::move(resource))
+		owner(std::shared_ptr<R> resource, buffer::view<T> view)
+		: owner(wrap(std::move(resource)), view)
 		{}
 		template<class It>
 		owner(It&& b, It&& e) noexcept
@@ -148,30 +401,71 @@ namespace utils {
 		{}
 		template<class Container>
 		owner(Container c)
-		: owner(std::make_shared<ContainerResource<Container>>(std::forward<Container>(c)))
-		{}
+		{
+			if constexpr(inline_capacity > 0) {
+				if(c.size() <= inline_capacity) {
+					assign(c.data(), c.size());
+					return;
+				}
+			}
+			*this = buffer::make<ContainerResource<Container>>(std::move(c));
+		}
 		template<std::size_t Size>
 		owner(T(&value)[Size]) noexcept
 		: base(value)
 		{}
-		owner() = default;
+		owner() noexcept
+		{}
 		owner(buffer::view<T>) = delete;
 		owner(const owner&) = delete;
-		owner(owner&&) = default;
+		owner(owner&& other) noexcept
+		{
+			steal(other);
+		}
 		owner& operator=(const owner&) = delete;
-		owner& operator=(owner&&) = default;
+		owner& operator=(owner&& other) noexcept
+		{
+			if(this != &other) {
+				reset();
+				steal(other);
+			}
+			return *this;
+		}
+		~owner()
+		{
+			reset();
+		}
 	public:
+		static owner copy(const value_t* data, std::size_t size)
+		{
+			if constexpr(inline_capacity > 0) {
+				if(size <= inline_capacity) {
+					owner result;
+					result.assign(data, size);
+					return result;
+				}
+			}
+			return owner(std::vector<value_t>(data, data + size));
+		}
+		bool embedded() const noexcept
+		{
+			return is_inline();
+		}
 		owner first(std::size_t count) noexcept
 		{
-			return owner(resource, base::first(count));
+			return share(base::first(count));
 		}
 		owner last(std::size_t count) noexcept
 		{
-			return owner(resource, base::last(count));
+			return share(base::last(count));
+		}
+		owner slice(std::size_t offset, std::size_t count) const noexcept
+		{
+			return share(base::slice(offset, count));
 		}
-		owner share() noexcept
+		owner share() const noexcept
 		{
-			return owner(resource);
+			return share(*this);
 		}
 	public:
 		operator owner<const T>() const noexcept
@@ -180,4 +474,20 @@ namespace utils {
 		}
 	};
 
-}
\ No newline at end of file
+	template<class R, class... Args>
+	auto buffer::make(Args&&... args)
+	{
+		using T = std::remove_pointer_t<decltype(std::declval<const R&>().begin())>;
+		return owner<T>(static_cast<Resource<T>*>(details::allocate_resource<R>(std::forward<Args>(args)...)));
+	}
+
+	template<class R, class... Args>
+	auto buffer::make_local(Args&&... args)
+	{
+		using T = std::remove_pointer_t<decltype(std::declval<const R&>().begin())>;
+		auto* resource = details::allocate_resource<R>(std::forward<Args>(args)...);
+		resource->local = true;
+		return owner<T>(static_cast<Resource<T>*>(resource));
+	}
+
+}
@@ -0,0 +1,54 @@
+#include <utils/bench.hpp>
+#include <utils/channel/bounded.hpp>
+#include <utils/channel/channel.hpp>
+#include <utils/channel/input.hpp>
+#include <utils/channel/output.hpp>
+#include <utils/channel/transform.hpp>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+int main(int argc, const char* argv[])
+{
+	utils::bench::suite suite("utils-channel", argc, argv);
+	using input_t = utils::channel::input<const int&, std::vector<int>::const_iterator>;
+	using output_t = utils::channel::output<int, int*>;
+	constexpr std::size_t count = 1u << 20;
+	std::vector<int> source(count);
+	std::iota(source.begin(), source.end(), 0);
+	std::vector<int> target(count);
+	const auto square = [](auto& value) {
+		return value * value;
+	};
+
+	suite.run("channel/loop", count, utils::bench::unit::items, [&] {
+		std::transform(source.cbegin(), source.cend(), target.begin(), square);
+		return target.back();
+	});
+	suite.run("channel/transform", count, utils::bench::unit::items, [&] {
+		input_t(source.cbegin(), source.cend()) >> utils::channel::transform(square) >> output_t(target.data(), target.data() + target.size());
+		return target.back();
+	});
+	suite.run("channel/spsc", count, utils::bench::unit::items, [&] {
+		auto [reader, writer] = utils::channel::spsc<int>(1024);
+		std::thread producer([&source, &square, writer = std::move(writer)]() mutable {
+			input_t(source.cbegin(), source.cend()) >> utils::channel::transform(square) >> std::move(writer);
+		});
+		std::move(reader) >> output_t(target.data(), target.data() + target.size());
+		producer.join();
+		return target.back();
+	});
+	suite.run("channel/mpmc", count, utils::bench::unit::items, [&] {
+		auto [reader, writer] = utils::channel::mpmc<int>(1024);
+		std::thread producer([&source, &square, writer = std::move(writer)]() mutable {
+			input_t(source.cbegin(), source.cend()) >> utils::channel::transform(square) >> std::move(writer);
+		});
+		std::move(reader) >> output_t(target.data(), target.data() + target.size());
+		producer.join();
+		return target.back();
+	});
+	suite.compare("channel/transform", "channel/loop");
+	suite.compare("channel/mpmc", "channel/spsc");
+	return suite.finish();
+}
@@ -0,0 +1,328 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <utils/channel/ichannel.hpp>
+#include <utils/channel/ochannel.hpp>
+
+namespace utils::channel {
+
+	namespace details
+	{
+		inline constexpr std::size_t cacheline = 64;
+
+		inline std::size_t bounded_capacity(std::size_t capacity) noexcept
+		{
+			std::size_t result = 2;
+			while(result < capacity)
+				result <<= 1;
+			return result;
+		}
+
+		class backoff
+		{
+			unsigned spins = 0;
+		public:
+			void operator()() noexcept
+			{
+				if(spins++ < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+					__builtin_ia32_pause();
+#endif
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		};
+
+		template<class T>
+		class spsc_ring
+		{
+			const std::size_t mask;
+			std::unique_ptr<T[]> values;
+			alignas(cacheline) std::atomic<std::size_t> head{0};
+			std::size_t cached_tail = 0;
+			alignas(cacheline) std::atomic<std::size_t> tail{0};
+			std::size_t cached_head = 0;
+		public:
+			explicit spsc_ring(std::size_t capacity)
+			: mask(bounded_capacity(capacity) - 1)
+			, values(new T[mask + 1])
+			{}
+		public:
+			bool push(T& value)
+			{
+				const auto position = tail.load(std::memory_order_relaxed);
+				if(position - cached_head > mask) {
+					cached_head = head.load(std::memory_order_acquire);
+					if(position - cached_head > mask)
+						return false;
+				}
+				values[position & mask] = std::move(value);
+				tail.store(position + 1, std::memory_order_release);
+				return true;
+			}
+			bool pop(T& value)
+			{
+				const auto position = head.load(std::memory_order_relaxed);
+				if(position == cached_tail) {
+					cached_tail = tail.load(std::memory_order_acquire);
+					if(position == cached_tail)
+						return false;
+				}
+				value = std::move(values[position & mask]);
+				head.store(position + 1, std::memory_order_release);
+				return true;
+			}
+			std::size_t push(T* begin, std::size_t size)
+			{
+				const auto position = tail.load(std::memory_order_relaxed);
+				if(position - cached_head + size > mask + 1)
+					cached_head = head.load(std::memory_order_acquire);
+				const auto count = std::min(size, mask + 1 - (position - cached_head));
+				for(std::size_t i = 0; i < count; ++i)
+					values[(position + i) & mask] = std::move(begin[i]);
+				tail.store(position + count, std::memory_order_release);
+				return count;
+			}
+			std::size_t pop(T* begin, std::size_t size)
+			{
+				const auto position = head.load(std::memory_order_relaxed);
+				if(cached_tail - position < size)
+					cached_tail = tail.load(std::memory_order_acquire);
+				const auto count = std::min(size, cached_tail - position);
+				for(std::size_t i = 0; i < count; ++i)
+					begin[i] = std::move(values[(position + i) & mask]);
+				head.store(position + count, std::memory_order_release);
+				return count;
+			}
+			bool empty() const noexcept
+			{
+				return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+			}
+		};
+
+		template<class T>
+		class mpmc_ring
+		{
+			struct cell
+			{
+				std::atomic<std::size_t> sequence;
+				T value;
+			};
+			const std::size_t mask;
+			std::unique_ptr<cell[]> cells;
+			alignas(cacheline) std::atomic<std::size_t> head{0};
+			alignas(cacheline) std::atomic<std::size_t> tail{0};
+		public:
+			explicit mpmc_ring(std::size_t capacity)
+			: mask(bounded_capacity(capacity) - 1)
+			, cells(new cell[mask + 1])
+			{
+				for(std::size_t i = 0; i <= mask; ++i)
+					cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		public:
+			bool push(T& value)
+			{
+				auto position = tail.load(std::memory_order_relaxed);
+				for(;;) {
+					auto& target = cells[position & mask];
+					const auto sequence = target.sequence.load(std::memory_order_acquire);
+					const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+					if(difference == 0) {
+						if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							target.value = std::move(value);
+							target.sequence.store(position + 1, std::memory_order_release);
+							return true;
+						}
+					} else if(difference < 0) {
+						return false;
+					} else {
+						position = tail.load(std::memory_order_relaxed);
+					}
+				}
+			}
+			bool pop(T& value)
+			{
+				auto position = head.load(std::memory_order_relaxed);
+				for(;;) {
+					auto& source = cells[position & mask];
+					const auto sequence = source.sequence.load(std::memory_order_acquire);
+					const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+					if(difference == 0) {
+						if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							value = std::move(source.value);
+							source.sequence.store(position + mask + 1, std::memory_order_release);
+							return true;
+						}
+					} else if(difference < 0) {
+						return false;
+					} else {
+						position = head.load(std::memory_order_relaxed);
+					}
+				}
+			}
+			std::size_t push(T* begin, std::size_t size)
+			{
+				std::size_t count = 0;
+				while(count < size && push(begin[count]))
+					++count;
+				return count;
+			}
+			std::size_t pop(T* begin, std::size_t size)
+			{
+				std::size_t count = 0;
+				while(count < size && pop(begin[count]))
+					++count;
+				return count;
+			}
+			bool empty() const noexcept
+			{
+				const auto position = head.load(std::memory_order_acquire);
+				return cells[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+			}
+		};
+
+		template<class Ring>
+		struct bounded_state
+		{
+			Ring ring;
+			std::atomic<bool> closed{false};
+			std::atomic<std::size_t> readers{0};
+			std::atomic<std::size_t> writers{0};
+		public:
+			explicit bounded_state(std::size_t capacity)
+			: ring(capacity)
+			{}
+		};
+	}
+
+	template<class T, class Ring>
+	class ibounded final: public ichannel<T>
+	{
+		std::shared_ptr<details::bounded_state<Ring>> state;
+	public:
+		explicit ibounded(std::shared_ptr<details::bounded_state<Ring>> state) noexcept
+		: state(std::move(state))
+		{
+			this->state->readers.fetch_add(1, std::memory_order_relaxed);
+		}
+		ibounded(const ibounded& other) noexcept
+		: ibounded(other.state)
+		{}
+		ibounded(ibounded&&) noexcept = default;
+		ibounded& operator=(const ibounded&) = delete;
+		ibounded& operator=(ibounded&&) = delete;
+		~ibounded() override
+		{
+			if(state && state->readers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				state->closed.store(true, std::memory_order_release);
+		}
+	public:
+		using value_type = T;
+		T get() override
+		{
+			T value;
+			for(details::backoff wait; !state->ring.pop(value); wait())
+				if(state->closed.load(std::memory_order_acquire) && !state->ring.pop(value))
+					throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::channel: get from a closed channel");
+			return value;
+		}
+		void get(buffer::view<T>& values) override
+		{
+			std::size_t count = 0;
+			while(!values.empty() && !count && closed())
+				count = state->ring.pop(values.data(), values.size());
+			values = values.first(count);
+		}
+		bool closed() const noexcept override
+		{
+			for(details::backoff wait; state->ring.empty(); wait())
+				if(state->closed.load(std::memory_order_acquire))
+					return !state->ring.empty();
+			return true;
+		}
+		void close() override
+		{
+			state->closed.store(true, std::memory_order_release);
+			for(T value; state->ring.pop(value); );
+		}
+	};
+
+	template<class T, class Ring>
+	class obounded final: public ochannel<T>
+	{
+		std::shared_ptr<details::bounded_state<Ring>> state;
+	public:
+		explicit obounded(std::shared_ptr<details::bounded_state<Ring>> state) noexcept
+		: state(std::move(state))
+		{
+			this->state->writers.fetch_add(1, std::memory_order_relaxed);
+		}
+		obounded(const obounded& other) noexcept
+		: obounded(other.state)
+		{}
+		obounded(obounded&&) noexcept = default;
+		obounded& operator=(const obounded&) = delete;
+		obounded& operator=(obounded&&) = delete;
+		~obounded() override
+		{
+			if(state && state->writers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				state->closed.store(true, std::memory_order_release);
+		}
+	public:
+		using value_type = T;
+		void put(T value) override
+		{
+			for(details::backoff wait; closed() || !state->ring.push(value); wait())
+				if(closed())
+					throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::channel: put to a closed channel");
+		}
+		void put(buffer::view<T> values) override
+		{
+			for(details::backoff wait; !values.empty(); ) {
+				if(closed())
+					throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::channel: put to a closed channel");
+				if(const auto count = state->ring.push(values.data(), values.size())) {
+					values.first(count);
+					wait = {};
+				} else {
+					wait();
+				}
+			}
+		}
+		bool closed() const noexcept override
+		{
+			return state->closed.load(std::memory_order_acquire);
+		}
+		void close() override
+		{
+			state->closed.store(true, std::memory_order_release);
+		}
+		operator bool() const noexcept
+		{
+			return !closed();
+		}
+	};
+
+	template<class T>
+	auto spsc(std::size_t capacity)
+	{
+		using ring_t = details::spsc_ring<T>;
+		auto state = std::make_shared<details::bounded_state<ring_t>>(capacity);
+		return std::make_pair(ibounded<T, ring_t>(state), obounded<T, ring_t>(state));
+	}
+
+	template<class T>
+	auto mpmc(std::size_t capacity)
+	{
+		using ring_t = details::mpmc_ring<T>;
+		auto state = std::make_shared<details::bounded_state<ring_t>>(capacity);
+		return std::make_pair(ibounded<T, ring_t>(state), obounded<T, ring_t>(state));
+	}
+}
@@ -1,30 +1,88 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <type_traits>
 #include <utility>
 #include <utils/channel/ichannel.hpp>
 #include <utils/channel/ochannel.hpp>
 
 namespace utils::channel {
+
+	namespace details
+	{
+		template<class IChannel, class OChannel>
+		inline constexpr bool batch_pipe_v = is_batch_ichannel_v<IChannel>
+			&& is_batch_ochannel_v<OChannel, std::remove_cv_t<std::remove_reference_t<typename IChannel::value_type>>>
+			&& std::is_default_constructible_v<std::remove_cv_t<std::remove_reference_t<typename IChannel::value_type>>>;
+
+		template<class OChannel, class = void>
+		struct ochannel_room
+		{
+			static std::size_t get(const OChannel&, std::size_t limit) noexcept
+			{
+				return limit;
+			}
+		};
+
+		template<class OChannel>
+		struct ochannel_room<OChannel, std::void_t<decltype(std::declval<const OChannel&>().room())>>
+		{
+			static std::size_t get(const OChannel& ochannel, std::size_t limit) noexcept
+			{
+				return std::min<std::size_t>(limit, ochannel.room());
+			}
+		};
+
+		// Never takes more from the input than the output has room for, so
+		// whatever a full output refuses stays in the input.
+		template<class IChannel, class OChannel>
+		void batch_pipe(IChannel& ichannel, OChannel& ochannel)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<typename IChannel::value_type>>;
+			std::array<value_t, batch_size> block;
+			for(;;) {
+				if(!ochannel) {
+					ochannel.close();
+					break;
+				}
+				buffer::view<value_t> values(block.data(), ochannel_room<OChannel>::get(ochannel, block.size()));
+				ichannel.get(values);
+				if(values.empty())
+					break;
+				ochannel.put(values);
+			}
+		}
+	}
+
 	template<class IChannel, class OChannel>
 	void operator >> (IChannel ichannel, OChannel ochannel)
 	{
-		for(decltype(auto) value: irange(ichannel)) {
-			if(ochannel) {
-				ochannel.put(std::move(value));
-			} else {
-				ochannel.close();
-				break;
+		if constexpr(details::batch_pipe_v<IChannel, OChannel>) {
+			details::batch_pipe(ichannel, ochannel);
+		} else {
+			for(decltype(auto) value: irange(std::move(ichannel))) {
+				if(ochannel) {
+					ochannel.put(std::move(value));
+				} else {
+					ochannel.close();
+					break;
+				}
 			}
 		}
 	}
 	template<class OChannel, class IChannel>
 	void operator << (OChannel ochannel, IChannel ichannel)
 	{
-		for(decltype(auto) value: irange(ichannel)) {
-			if(ochannel) {
-				ochannel.put(std::move(value));
-			} else {
-				ochannel.close();
-				break;
+		if constexpr(details::batch_pipe_v<IChannel, OChannel>) {
+			details::batch_pipe(ichannel, ochannel);
+		} else {
+			for(decltype(auto) value: irange(std::move(ichannel))) {
+				if(ochannel) {
+					ochannel.put(std::move(value));
+				} else {
+					ochannel.close();
+					break;
+				}
 			}
 		}
 	}
@@ -1,15 +1,26 @@
 #pragma once
 #include <utility>
 #include <iterator>
+#include <type_traits>
+#include <utils/buffer.hpp>
 
 namespace utils::channel {
 
+	inline constexpr std::size_t batch_size = 256;
+
 	template<class T>
 	class ichannel
 	{
 	public:
 		virtual ~ichannel() = default;
 		virtual T get() = 0;
+		virtual void get(buffer::view<T>& values)
+		{
+			std::size_t count = 0;
+			for(; count < values.size() && closed(); ++count)
+				values[count] = get();
+			values = values.first(count);
+		}
 		virtual bool closed() const noexcept = 0;
 		virtual void close() = 0;
 	public:
@@ -82,6 +93,17 @@ namespace utils::channel {
 		}
 	};
 
+	template<class Channel, class = void>
+	struct is_batch_ichannel: std::false_type {};
+
+	template<class Channel>
+	struct is_batch_ichannel<Channel, std::void_t<decltype(std::declval<Channel&>().get(
+		std::declval<buffer::view<std::remove_cv_t<std::remove_reference_t<typename Channel::value_type>>>&>()
+	))>>: std::true_type {};
+
+	template<class Channel>
+	inline constexpr bool is_batch_ichannel_v = is_batch_ichannel<Channel>::value;
+
 	template<class Channel, class T>
 	auto irange(Channel&& channel, T&& value)
 	{
@@ -36,6 +36,13 @@ namespace utils::channel {
 		{
 			return *begin_++;
 		}
+		void get(buffer::view<std::remove_cv_t<std::remove_reference_t<T>>>& values)
+		{
+			std::size_t count = 0;
+			for(; count < values.size() && begin_ != end_; ++count, ++begin_)
+				values[count] = *begin_;
+			values = values.first(count);
+		}
 		bool closed() const noexcept
 		{
 			return begin_ != end_;
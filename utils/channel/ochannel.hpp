@@ -1,6 +1,7 @@
 #pragma once
 #include <utility>
 #include <type_traits>
+#include <utils/buffer.hpp>
 
 namespace utils::channel {
 
@@ -10,6 +11,11 @@ namespace utils::channel {
 	public:
 		virtual ~ochannel() = default;
 		virtual void put(T) = 0;
+		virtual void put(buffer::view<T> values)
+		{
+			for(auto& value: values)
+				put(std::move(value));
+		}
 		virtual bool closed() const noexcept = 0;
 		virtual void close() = 0;
 	public:
@@ -57,4 +63,13 @@ namespace utils::channel {
 		}
 	};
 
+	template<class Channel, class T, class = void>
+	struct is_batch_ochannel: std::false_type {};
+
+	template<class Channel, class T>
+	struct is_batch_ochannel<Channel, T, std::void_t<decltype(std::declval<Channel&>().put(std::declval<buffer::view<T>>()))>>: std::true_type {};
+
+	template<class Channel, class T>
+	inline constexpr bool is_batch_ochannel_v = is_batch_ochannel<Channel, T>::value;
+
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #pragma once
+#include <iterator>
+#include <system_error>
 #include <utils/channel/ochannel.hpp>
 
 namespace utils::channel {
@@ -29,6 +31,19 @@ namespace utils::channel {
 			*begin_ = std::move(value);
 			++begin_;
 		}
+		void put(buffer::view<T> values)
+		{
+			if(values.size() > room())
+				throw std::system_error(make_error_code(std::errc::no_buffer_space), "utils::channel: put past the end of an output");
+			for(auto& value: values) {
+				*begin_ = std::move(value);
+				++begin_;
+			}
+		}
+		std::size_t room() const noexcept
+		{
+			return static_cast<std::size_t>(std::distance(begin_, end_));
+		}
 		operator bool() const noexcept
 		{
 			return begin_ != end_;
@@ -58,6 +73,10 @@ namespace utils::channel {
 			*it = std::move(value);
 			++it;
 		}
+		void put(buffer::view<T> values)
+		{
+			std::move(values.begin(), values.end(), it);
+		}
 		operator bool() const noexcept
 		{
 			return !closed;
@@ -1,9 +1,14 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <utils/channel/bounded.hpp>
 #include <utils/channel/channel.hpp>
 #include <utils/channel/input.hpp>
 #include <utils/channel/output.hpp>
 #include <utils/channel/transform.hpp>
+#include <array>
+#include <numeric>
+#include <thread>
+#include <vector>
 
 namespace {
 
@@ -40,3 +45,162 @@ TEST_CASE("test utils channel with transform function", "[utils], [channel], [tr
 	};
 	REQUIRE((utils::channel::input({1, 2, 3}) >> utils::channel::transform(pow2) >> vectorize) == (utils::channel::input({1, 4, 9}) >> vectorize));
 }
+
+TEST_CASE("utils channel bounded single producer single consumer", "[utils], [channel], [bounded]")
+{
+	constexpr int count = 100000;
+	auto [reader, writer] = utils::channel::spsc<int>(64);
+	std::thread producer([writer = std::move(writer)]() mutable {
+		for(int i = 0; i < count; ++i)
+			writer.put(i);
+	});
+	int expected = 0;
+	for(auto value: utils::channel::irange(std::move(reader))) {
+		REQUIRE(value == expected);
+		++expected;
+	}
+	producer.join();
+	REQUIRE(expected == count);
+}
+
+TEST_CASE("utils channel bounded multiple producers multiple consumers", "[utils], [channel], [bounded]")
+{
+	constexpr long count = 20000;
+	constexpr long threads = 4;
+	auto [reader, writer] = utils::channel::mpmc<long>(128);
+	std::vector<std::thread> producers;
+	for(long p = 0; p < threads; ++p)
+		producers.emplace_back([p, writer = writer]() mutable {
+			for(long i = 0; i < count; ++i)
+				writer.put(p * count + i + 1);
+		});
+	std::vector<long> sums(threads);
+	std::vector<std::thread> consumers;
+	for(long c = 0; c < threads; ++c)
+		consumers.emplace_back([&sum = sums[c], reader = reader]() mutable {
+			try {
+				while(reader.closed())
+					sum += reader.get();
+			} catch(const std::system_error&) {
+			}
+		});
+	{
+		auto drop = std::move(writer);
+		auto unused = std::move(reader);
+	}
+	for(auto& producer: producers)
+		producer.join();
+	for(auto& consumer: consumers)
+		consumer.join();
+	const long total = threads * count;
+	REQUIRE(std::accumulate(sums.begin(), sums.end(), 0l) == total * (total + 1) / 2);
+}
+
+TEST_CASE("utils channel bounded close semantics", "[utils], [channel], [bounded]")
+{
+	{
+		auto [reader, writer] = utils::channel::spsc<int>(4);
+		utils::channel::input{{1, 2, 3}} >> std::move(writer);
+		REQUIRE((std::move(reader) >> vectorize) == std::vector<int>{1, 2, 3});
+	}
+	{
+		auto [reader, writer] = utils::channel::spsc<int>(4);
+		REQUIRE(writer);
+		writer.put(1);
+		reader.close();
+		REQUIRE(!reader.closed());
+		REQUIRE(!writer);
+		REQUIRE_THROWS_AS(writer.put(2), std::system_error);
+		REQUIRE_THROWS_AS(reader.get(), std::system_error);
+	}
+	{
+		auto [reader, writer] = utils::channel::mpmc<std::string>(2);
+		writer.put("a");
+		writer.put("b");
+		writer.close();
+		REQUIRE(reader.closed());
+		REQUIRE(reader.get() == "a");
+		REQUIRE(reader.get() == "b");
+		REQUIRE(!reader.closed());
+	}
+}
+
+TEST_CASE("utils channel batch transfers", "[utils], [channel], [batch]")
+{
+	using input_t = utils::channel::input<const int&, std::vector<int>::const_iterator>;
+	using output_t = utils::channel::output<int, int*>;
+	using ring_t = utils::channel::details::spsc_ring<int>;
+	static_assert(utils::channel::is_batch_ichannel_v<input_t>);
+	static_assert(utils::channel::is_batch_ochannel_v<output_t, int>);
+	static_assert(utils::channel::is_batch_ichannel_v<utils::channel::ibounded<int, ring_t>>);
+	static_assert(utils::channel::is_batch_ochannel_v<utils::channel::obounded<int, ring_t>, int>);
+
+	std::vector<int> source(1000);
+	std::iota(source.begin(), source.end(), 0);
+	auto square = [](auto& value) {
+		return value * value;
+	};
+	using transform_t = decltype(input_t(source.cbegin(), source.cend()) >> utils::channel::transform(square));
+	static_assert(utils::channel::is_batch_ichannel_v<transform_t>);
+
+	std::vector<int> target(source.size() + 1, -1);
+	input_t(source.cbegin(), source.cend()) >> utils::channel::transform(square) >> output_t(target.data(), target.data() + target.size());
+	for(std::size_t i = 0; i < source.size(); ++i)
+		REQUIRE(target[i] == source[i] * source[i]);
+	REQUIRE(target.back() == -1);
+
+	auto [reader, writer] = utils::channel::spsc<int>(100);
+	std::thread producer([&source, writer = std::move(writer)]() mutable {
+		input_t(source.cbegin(), source.cend()) >> std::move(writer);
+	});
+	std::vector<int> received;
+	std::array<int, 64> block;
+	for(;;) {
+		utils::buffer::view<int> values(block.data(), block.size());
+		reader.get(values);
+		if(values.empty())
+			break;
+		received.insert(received.end(), values.begin(), values.end());
+	}
+	producer.join();
+	REQUIRE(received == source);
+
+	auto [queue, feeder] = utils::channel::mpmc<int>(64);
+	for(int i = 0; i < 10; ++i)
+		feeder.put(i);
+	int head[5] = {};
+	queue >> utils::channel::output(head);
+	REQUIRE(std::vector<int>(head, head + 5) == std::vector<int>{0, 1, 2, 3, 4});
+	feeder.close();
+	REQUIRE((std::move(queue) >> vectorize) == std::vector<int>{5, 6, 7, 8, 9});
+
+	int small[2] = {};
+	int values[3] = {1, 2, 3};
+	output_t full(small, small + 2);
+	REQUIRE_THROWS_AS(full.put(utils::buffer::view<int>(values)), std::system_error);
+}
+
+TEST_CASE("utils channel batch pipes keep per-element semantics", "[utils], [channel], [batch]")
+{
+	struct boxed
+	{
+		int value;
+		explicit boxed(int value) noexcept
+		: value(value)
+		{}
+	};
+	using boxes_t = utils::channel::input<boxed, std::vector<boxed>::iterator>;
+	auto unbox = [](boxed&& box) {
+		return box.value;
+	};
+	static_assert(!utils::channel::details::batch_pipe_v<boxes_t, utils::channel::output<boxed, boxed*>>);
+	static_assert(!utils::channel::is_batch_ichannel_v<decltype(std::declval<boxes_t>() >> utils::channel::transform(unbox))>);
+
+	auto [reader, writer] = utils::channel::spsc<int>(16);
+	for(int i = 0; i < 10; ++i)
+		writer.put(i);
+	writer.close();
+	int doubled[10] = {};
+	std::move(reader) >> utils::channel::transform([](int&& value) { return value * 2; }) >> utils::channel::output(doubled);
+	REQUIRE(std::vector<int>(doubled, doubled + 10) == std::vector<int>{0, 2, 4, 6, 8, 10, 12, 14, 16, 18});
+}
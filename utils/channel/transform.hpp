@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <functional>
 #include <utils/channel/ichannel.hpp>
 
@@ -36,6 +37,18 @@ namespace utils::channel {
 		{
 			return transform.function(channel.get());
 		}
+		template<class U, class Channel = IChannel, class = std::enable_if_t<is_batch_ichannel_v<Channel>
+			&& std::is_default_constructible_v<std::remove_cv_t<std::remove_reference_t<typename Channel::value_type>>>>>
+		void get(buffer::view<U>& values)
+		{
+			using input_t = std::remove_cv_t<std::remove_reference_t<typename Channel::value_type>>;
+			std::array<input_t, batch_size> block;
+			buffer::view<input_t> inputs(block.data(), std::min(values.size(), block.size()));
+			channel.get(inputs);
+			for(std::size_t i = 0; i < inputs.size(); ++i)
+				values[i] = transform.function(std::forward<typename Channel::value_type>(inputs[i]));
+			values = values.first(inputs.size());
+		}
 		bool closed() const noexcept
 		{
 			return channel.closed();
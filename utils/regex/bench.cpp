@@ -0,0 +1,190 @@
+#include <utils/bench.hpp>
+#include <utils/regex/regular.hpp>
+#include <utils/regex/dfa.hpp>
+#include <utils/regex/stream.hpp>
+#include <utils/regex/search.hpp>
+#include <utils/regex/memo.hpp>
+#include <utils/stream/items.hpp>
+#include <utils/stream/chunked.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+	constexpr std::size_t corpus_size = 1024u * 1024u;
+
+	std::string repeat(std::string_view unit)
+	{
+		std::string text;
+		text.reserve(corpus_size + unit.size());
+		while(text.size() < corpus_size)
+			text += unit;
+		return text;
+	}
+
+	template<class Rule>
+	std::size_t tokens(const Rule& rule, const std::string& text)
+	{
+		std::size_t count = 0;
+		const char* it = text.data();
+		const char* const end = it + text.size();
+		while(it != end && rule.scan(it, end))
+			++count;
+		return count;
+	}
+
+	template<class Rule>
+	std::size_t every(const Rule& rule, const std::string& text)
+	{
+		std::size_t count = 0;
+		const char* const end = text.data() + text.size();
+		for(const char* at = text.data(); at != end;) {
+			const char* it = at;
+			if(rule.scan(it, end) && it != at) {
+				++count;
+				at = it;
+			} else {
+				++at;
+			}
+		}
+		return count;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	utils::bench::suite suite("utils-regex", argc, argv);
+	const auto& match = utils::match;
+	constexpr auto symbol = match('a', 'z') | match('A', 'Z') | match("_");
+	constexpr auto digit = match('0', '9');
+	constexpr auto identifier = symbol & *(symbol | digit);
+	constexpr auto number = +digit & !(match(".") & *digit);
+	constexpr auto space = +match[" \t\r\n"];
+	constexpr auto keywords = match("and") | match("break") | match("goto") | match("local") | match("return") | match("while");
+	constexpr auto word = match('a', 'z') | match('0', '9') | match["_"];
+
+	const auto literals = repeat("abc");
+	suite.run("regex/literal", literals.size(), utils::bench::unit::bytes, [&] {
+		return tokens(match("abc"), literals);
+	});
+	const auto words = repeat("local return while break goto and ");
+	suite.run("regex/alternative", words.size(), utils::bench::unit::bytes, [&] {
+		return tokens(keywords | space, words);
+	});
+	constexpr auto operators = match("...") | match("..") | match(".") | match("::") | match(":") | match("==") | match("=")
+		| match("~=") | match("~") | match("<<") | match("<=") | match("<") | match(">>") | match(">=") | match(">")
+		| match("//") | match("/") | match("+") | match("-") | match("*") | match("%") | match("^") | match("#")
+		| match("&") | match("|") | match("(") | match(")") | match("{") | match("}") | match("[") | match("]")
+		| match(";") | match(",");
+	const auto punctuation = repeat("...==~=<<>=//,;[]{}()#^%*-+|&~<>=.:");
+	suite.run("regex/operators", punctuation.size(), utils::bench::unit::bytes, [&] {
+		return tokens(operators, punctuation);
+	});
+	suite.run("regex/operators-value", punctuation.size(), utils::bench::unit::bytes, [&] {
+		std::size_t sum = 0;
+		const char* it = punctuation.data();
+		const char* const end = it + punctuation.size();
+		while(it != end)
+			if(const auto result = operators(it, end))
+				sum += result->index();
+			else
+				break;
+		return sum;
+	});
+	constexpr auto operator_set = utils::literals("...", "..", ".", "::", ":", "==", "=", "~=", "~", "<<", "<=", "<", ">>", ">=", ">", "//", "/",
+		"+", "-", "*", "%", "^", "#", "&", "|", "(", ")", "{", "}", "[", "]", ";", ",");
+	suite.run("regex/literal-set", punctuation.size(), utils::bench::unit::bytes, [&] {
+		std::size_t sum = 0;
+		const char* it = punctuation.data();
+		const char* const end = it + punctuation.size();
+		while(it != end)
+			if(const auto result = operator_set(it, end))
+				sum += *result;
+			else
+				break;
+		return sum;
+	});
+	const auto letters = repeat("aZ_q_Xz");
+	suite.run("regex/class-alternative", letters.size(), utils::bench::unit::bytes, [&] {
+		return tokens(symbol, letters);
+	});
+	const auto runs = repeat(std::string(255, 'w') + "-");
+	suite.run("regex/byteclass-star", runs.size(), utils::bench::unit::bytes, [&] {
+		return tokens(+word | match("-"), runs);
+	});
+	const auto script = repeat("local value = compute(items, 42) -- adjust the total by hand\nif value > limit then return end\n--[[ disabled ]]\n");
+	const utils::buffer::view<const char> script_view(script.data(), script.size());
+	constexpr auto comment = match("--[[");
+	suite.run("regex/find-comment", script.size(), utils::bench::unit::bytes, [&] {
+		return utils::find_all(comment, script_view).size();
+	});
+	suite.run("regex/find-comment-naive", script.size(), utils::bench::unit::bytes, [&] {
+		return every(comment, script);
+	});
+	constexpr auto call = identifier & match("(");
+	suite.run("regex/find-call", script.size(), utils::bench::unit::bytes, [&] {
+		return utils::find_all(call, script_view).size();
+	});
+	suite.run("regex/find-call-naive", script.size(), utils::bench::unit::bytes, [&] {
+		return every(call, script);
+	});
+	constexpr auto digits = +digit;
+	suite.run("regex/find-number", script.size(), utils::bench::unit::bytes, [&] {
+		return utils::find_all(digits, script_view).size();
+	});
+	suite.run("regex/find-number-naive", script.size(), utils::bench::unit::bytes, [&] {
+		return every(digits, script);
+	});
+	constexpr auto path = identifier & *(match(".") & identifier);
+	constexpr auto target = utils::memo(1, path);
+	constexpr auto statement = (path & match("(") & path & match(")\n")) | (path & match("[") & path & match("]\n")) | (path & match(" = ") & path & match("\n"));
+	constexpr auto memoized = (target & match("(") & target & match(")\n")) | (target & match("[") & target & match("]\n")) | (target & match(" = ") & target & match("\n"));
+	const auto statements = repeat("config.window.size.width = layout.columns.total\n");
+	suite.run("regex/statements", statements.size(), utils::bench::unit::bytes, [&] {
+		return tokens(statement, statements);
+	});
+	suite.run("regex/statements-memo", statements.size(), utils::bench::unit::bytes, [&] {
+		utils::regex_memo memo;
+		std::size_t count = 0;
+		const char* it = statements.data();
+		const char* const end = it + statements.size();
+		while(it != end && utils::scan(memoized, it, end, memo))
+			++count;
+		return count;
+	});
+	const auto source = repeat("some_identifier_0123 3.1415 x 42\n");
+	suite.run("regex/sequence", source.size(), utils::bench::unit::bytes, [&] {
+		return tokens(identifier | number | space, source);
+	});
+	constexpr auto dfa = utils::compile(identifier | number | space);
+	suite.run("regex/dfa", source.size(), utils::bench::unit::bytes, [&] {
+		return tokens(dfa, source);
+	});
+	suite.run("regex/items", source.size(), utils::bench::unit::bytes, [&] {
+		constexpr auto rule = identifier | number | space;
+		utils::items chunks = utils::stream::chunked(source, 64u * 1024u);
+		std::size_t count = 0;
+		for(auto it = chunks.begin(); it != chunks.end() && utils::scan(rule, it, chunks.end());)
+			++count;
+		return count;
+	});
+	suite.run("regex/items-dfa", source.size(), utils::bench::unit::bytes, [&] {
+		utils::items chunks = utils::stream::chunked(source, 64u * 1024u);
+		std::size_t count = 0;
+		for(auto it = chunks.begin(); it != chunks.end() && utils::scan(dfa, it, chunks.end());)
+			++count;
+		return count;
+	});
+	suite.compare("regex/literal-set", "regex/operators-value");
+	suite.compare("regex/find-comment", "regex/find-comment-naive");
+	suite.compare("regex/find-call", "regex/find-call-naive");
+	suite.compare("regex/find-number", "regex/find-number-naive");
+	suite.compare("regex/statements-memo", "regex/statements");
+	suite.compare("regex/dfa", "regex/sequence");
+	suite.compare("regex/items", "regex/sequence");
+	suite.compare("regex/items-dfa", "regex/dfa");
+	suite.compare("regex/items-dfa", "regex/items");
+	return suite.finish();
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+
+	template<std::size_t Bits>
+	class regex_bitset
+	{
+		static constexpr std::size_t words = (Bits + 63u) / 64u;
+		std::array<std::uint64_t, words> values{};
+	public:
+		constexpr regex_bitset() noexcept = default;
+		regex_bitset(const regex_bitset&) = default;
+		regex_bitset& operator=(const regex_bitset&) = default;
+	public:
+		static constexpr std::size_t size() noexcept
+		{
+			return Bits;
+		}
+		constexpr bool test(std::size_t index) const noexcept
+		{
+			return (values[index / 64u] >> (index % 64u)) & 1u;
+		}
+		constexpr regex_bitset& set(std::size_t index) noexcept
+		{
+			values[index / 64u] |= std::uint64_t(1) << (index % 64u);
+			return *this;
+		}
+		constexpr regex_bitset& reset(std::size_t index) noexcept
+		{
+			values[index / 64u] &= ~(std::uint64_t(1) << (index % 64u));
+			return *this;
+		}
+		constexpr regex_bitset& flip() noexcept
+		{
+			for(std::size_t i = 0; i < words; ++i)
+				values[i] = ~values[i];
+			if constexpr(Bits % 64u != 0)
+				values[words - 1] &= (std::uint64_t(1) << (Bits % 64u)) - 1u;
+			return *this;
+		}
+		constexpr bool none() const noexcept
+		{
+			for(std::size_t i = 0; i < words; ++i)
+				if(values[i])
+					return false;
+			return true;
+		}
+		constexpr bool any() const noexcept
+		{
+			return !none();
+		}
+		constexpr std::size_t count() const noexcept
+		{
+			std::size_t result = 0;
+			for(std::size_t i = 0; i < Bits; ++i)
+				result += test(i);
+			return result;
+		}
+		constexpr std::uint64_t word(std::size_t index) const noexcept
+		{
+			return values[index];
+		}
+	public:
+		constexpr regex_bitset& operator|=(const regex_bitset& other) noexcept
+		{
+			for(std::size_t i = 0; i < words; ++i)
+				values[i] |= other.values[i];
+			return *this;
+		}
+		constexpr regex_bitset& operator&=(const regex_bitset& other) noexcept
+		{
+			for(std::size_t i = 0; i < words; ++i)
+				values[i] &= other.values[i];
+			return *this;
+		}
+		friend constexpr regex_bitset operator|(regex_bitset a, const regex_bitset& b) noexcept
+		{
+			return a |= b;
+		}
+		friend constexpr regex_bitset operator&(regex_bitset a, const regex_bitset& b) noexcept
+		{
+			return a &= b;
+		}
+		friend constexpr bool operator==(const regex_bitset& a, const regex_bitset& b) noexcept
+		{
+			for(std::size_t i = 0; i < words; ++i)
+				if(a.values[i] != b.values[i])
+					return false;
+			return true;
+		}
+		friend constexpr bool operator!=(const regex_bitset& a, const regex_bitset& b) noexcept
+		{
+			return !(a == b);
+		}
+	};
+
+	using regex_byteset = regex_bitset<256>;
+
+	template<class T>
+	constexpr std::uint8_t regex_byte(T value) noexcept
+	{
+		static_assert(sizeof(T) == 1, "only byte sized symbols can be indexed");
+		return static_cast<std::uint8_t>(value);
+	}
+
+}
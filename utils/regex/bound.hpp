@@ -0,0 +1,78 @@
+#pragma once
+
+namespace utils {
+
+	// Ends a scan at last. Comparing against it is a plain pointer compare;
+	// a scan that stops because it ran into last says so through hit(), so a
+	// caller can tell whether more input might have changed the match.
+	template<class T>
+	class regex_bound
+	{
+		const T* last;
+		bool* reached;
+	public:
+		constexpr regex_bound(const T* last, bool& reached) noexcept
+		: last(last), reached(&reached)
+		{}
+	public:
+		constexpr const T* get() const noexcept
+		{
+			return last;
+		}
+		constexpr bool hit(const T* it) const noexcept
+		{
+			if(it != last)
+				return false;
+			*reached = true;
+			return true;
+		}
+		friend constexpr bool operator==(const T* it, const regex_bound& bound) noexcept
+		{
+			return it == bound.last;
+		}
+		friend constexpr bool operator==(const regex_bound& bound, const T* it) noexcept
+		{
+			return it == bound.last;
+		}
+		friend constexpr bool operator!=(const T* it, const regex_bound& bound) noexcept
+		{
+			return it != bound.last;
+		}
+		friend constexpr bool operator!=(const regex_bound& bound, const T* it) noexcept
+		{
+			return it != bound.last;
+		}
+	};
+
+	namespace details
+	{
+		// Scans call hit() where they stop for want of input.
+		template<class End>
+		struct regex_end
+		{
+			static constexpr const End& get(const End& end) noexcept
+			{
+				return end;
+			}
+			template<class Begin>
+			static constexpr bool hit(const Begin& it, const End& end) noexcept
+			{
+				return it == end;
+			}
+		};
+
+		template<class T>
+		struct regex_end<regex_bound<T>>
+		{
+			static constexpr const T* get(const regex_bound<T>& end) noexcept
+			{
+				return end.get();
+			}
+			static constexpr bool hit(const T* it, const regex_bound<T>& end) noexcept
+			{
+				return end.hit(it);
+			}
+		};
+	}
+
+}
@@ -0,0 +1,544 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utils/regex/regular.hpp>
+#include <utils/regex/bitset.hpp>
+
+namespace utils {
+
+	template<class Regex>
+	struct regex_positions;
+
+	template<class Regex>
+	inline constexpr std::size_t regex_positions_v = regex_positions<Regex>::value;
+
+	template<class T, std::size_t Size>
+	struct regex_positions<regex<match_sequence_t<T, Size>>>: std::integral_constant<std::size_t, Size> {};
+
+	template<class T, std::size_t Size>
+	struct regex_positions<regex<match_anyof_t<T, Size>>>: std::integral_constant<std::size_t, 1> {};
+
+	template<class T>
+	struct regex_positions<regex<match_range_t<T>>>: std::integral_constant<std::size_t, 1> {};
+
+	template<class T, std::size_t Count, std::size_t Capacity>
+	struct regex_positions<regex<match_literals_t<T, Count, Capacity>>>: std::integral_constant<std::size_t, Capacity> {};
+
+	template<class ...Regexs>
+	struct regex_positions<regex<match_or_t<Regexs...>>>: std::integral_constant<std::size_t, (0 + ... + regex_positions_v<Regexs>)> {};
+
+	template<class ...Regexs>
+	struct regex_positions<regex<match_and_t<Regexs...>>>: std::integral_constant<std::size_t, (0 + ... + regex_positions_v<Regexs>)> {};
+
+	template<class Match>
+	struct regex_positions<regex<match_zero_plus<Match>>>: regex_positions<Match> {};
+
+	template<class Match>
+	struct regex_positions<regex<match_one_plus<Match>>>: regex_positions<Match> {};
+
+	template<class Match>
+	struct regex_positions<regex<match_optional<Match>>>: regex_positions<Match> {};
+
+	template<class Match>
+	struct regex_positions<regex<match_named<Match>>>: regex_positions<Match> {};
+
+	template<class Regex>
+	struct regex_ranges;
+
+	template<class Regex>
+	inline constexpr std::size_t regex_ranges_v = regex_ranges<Regex>::value;
+
+	template<class T, std::size_t Size>
+	struct regex_ranges<regex<match_sequence_t<T, Size>>>: std::integral_constant<std::size_t, Size> {};
+
+	template<class T, std::size_t Size>
+	struct regex_ranges<regex<match_anyof_t<T, Size>>>: std::integral_constant<std::size_t, Size> {};
+
+	template<class T>
+	struct regex_ranges<regex<match_range_t<T>>>: std::integral_constant<std::size_t, 1> {};
+
+	template<class T, std::size_t Count, std::size_t Capacity>
+	struct regex_ranges<regex<match_literals_t<T, Count, Capacity>>>: std::integral_constant<std::size_t, Capacity> {};
+
+	template<class ...Regexs>
+	struct regex_ranges<regex<match_or_t<Regexs...>>>: std::integral_constant<std::size_t, (0 + ... + regex_ranges_v<Regexs>)> {};
+
+	template<class ...Regexs>
+	struct regex_ranges<regex<match_and_t<Regexs...>>>: std::integral_constant<std::size_t, (0 + ... + regex_ranges_v<Regexs>)> {};
+
+	template<class Match>
+	struct regex_ranges<regex<match_zero_plus<Match>>>: regex_ranges<Match> {};
+
+	template<class Match>
+	struct regex_ranges<regex<match_one_plus<Match>>>: regex_ranges<Match> {};
+
+	template<class Match>
+	struct regex_ranges<regex<match_optional<Match>>>: regex_ranges<Match> {};
+
+	template<class Match>
+	struct regex_ranges<regex<match_named<Match>>>: regex_ranges<Match> {};
+
+	template<class Regex>
+	struct regex_input
+	{
+		using type = typename Regex::input_type;
+	};
+
+	template<class Regex, class ...Regexs>
+	struct regex_input<regex<match_or_t<Regex, Regexs...>>>: regex_input<Regex> {};
+
+	template<class Regex, class ...Regexs>
+	struct regex_input<regex<match_and_t<Regex, Regexs...>>>: regex_input<Regex> {};
+
+	template<class Match>
+	struct regex_input<regex<match_zero_plus<Match>>>: regex_input<Match> {};
+
+	template<class Match>
+	struct regex_input<regex<match_one_plus<Match>>>: regex_input<Match> {};
+
+	template<class Match>
+	struct regex_input<regex<match_optional<Match>>>: regex_input<Match> {};
+
+	template<class Match>
+	struct regex_input<regex<match_named<Match>>>: regex_input<Match> {};
+
+	template<class Regex>
+	using regex_input_t = typename regex_input<Regex>::type;
+
+	namespace details
+	{
+		template<std::size_t Positions>
+		struct regex_glushkov
+		{
+			using positions_t = regex_bitset<Positions>;
+			struct fragment
+			{
+				positions_t first{};
+				positions_t last{};
+				bool nullable = false;
+			};
+
+			std::array<regex_byteset, Positions> symbols{};
+			std::array<positions_t, Positions> follow{};
+			std::size_t count = 0;
+		private:
+			constexpr fragment symbol(const regex_byteset& set)
+			{
+				const auto position = count++;
+				symbols[position] = set;
+				fragment result;
+				result.first.set(position);
+				result.last.set(position);
+				return result;
+			}
+			constexpr void link(const positions_t& from, const positions_t& to)
+			{
+				for(std::size_t p = 0; p < Positions; ++p)
+					if(from.test(p))
+						follow[p] |= to;
+			}
+			constexpr static fragment alternative(fragment a, const fragment& b)
+			{
+				a.first |= b.first;
+				a.last |= b.last;
+				a.nullable = a.nullable || b.nullable;
+				return a;
+			}
+			constexpr fragment concatenation(fragment a, const fragment& b)
+			{
+				link(a.last, b.first);
+				if(a.nullable)
+					a.first |= b.first;
+				if(b.nullable)
+					a.last |= b.last;
+				else
+					a.last = b.last;
+				a.nullable = a.nullable && b.nullable;
+				return a;
+			}
+			template<class Tuple, std::size_t... I>
+			constexpr fragment alternatives(const Tuple& matchs, std::index_sequence<I...>)
+			{
+				fragment result;
+				((result = alternative(result, (*this)(std::get<I>(matchs)))), ...);
+				return result;
+			}
+			template<class Tuple, std::size_t... I>
+			constexpr fragment concatenations(const Tuple& matchs, std::index_sequence<I...>)
+			{
+				fragment result;
+				result.nullable = true;
+				((result = concatenation(result, (*this)(std::get<I>(matchs)))), ...);
+				return result;
+			}
+		public:
+			template<class T, std::size_t Size>
+			constexpr fragment operator()(const regex<match_sequence_t<T, Size>>& rule)
+			{
+				fragment result;
+				result.nullable = true;
+				for(const auto& value: regex_access::values(rule))
+					result = concatenation(result, symbol(regex_byteset().set(regex_byte(value))));
+				return result;
+			}
+			template<class T, std::size_t Size>
+			constexpr fragment operator()(const regex<match_anyof_t<T, Size>>& rule)
+			{
+				return symbol(regex_class<regex<match_anyof_t<T, Size>>>::set(rule));
+			}
+			template<class T>
+			constexpr fragment operator()(const regex<match_range_t<T>>& rule)
+			{
+				return symbol(regex_class<regex<match_range_t<T>>>::set(rule));
+			}
+			template<class T, std::size_t Count, std::size_t Capacity>
+			constexpr fragment operator()(const regex<match_literals_t<T, Count, Capacity>>& rule)
+			{
+				const auto& values = regex_access::values(rule);
+				const auto& offsets = regex_access::offsets(rule);
+				fragment result;
+				for(std::size_t i = 0; i < Count; ++i) {
+					fragment literal;
+					literal.nullable = true;
+					for(std::size_t at = offsets[i]; at < offsets[i + 1]; ++at)
+						literal = concatenation(literal, symbol(regex_byteset().set(regex_byte(values[at]))));
+					result = alternative(result, literal);
+				}
+				return result;
+			}
+			template<class ...Regexs>
+			constexpr fragment operator()(const regex<match_or_t<Regexs...>>& rule)
+			{
+				return alternatives(regex_access::matchs(rule), std::index_sequence_for<Regexs...>());
+			}
+			template<class ...Regexs>
+			constexpr fragment operator()(const regex<match_and_t<Regexs...>>& rule)
+			{
+				return concatenations(regex_access::matchs(rule), std::index_sequence_for<Regexs...>());
+			}
+			template<class Match>
+			constexpr fragment operator()(const regex<match_zero_plus<Match>>& rule)
+			{
+				auto result = (*this)(regex_access::match(rule));
+				link(result.last, result.first);
+				result.nullable = true;
+				return result;
+			}
+			template<class Match>
+			constexpr fragment operator()(const regex<match_one_plus<Match>>& rule)
+			{
+				auto result = (*this)(regex_access::match(rule));
+				link(result.last, result.first);
+				return result;
+			}
+			template<class Match>
+			constexpr fragment operator()(const regex<match_optional<Match>>& rule)
+			{
+				auto result = (*this)(regex_access::match(rule));
+				result.nullable = true;
+				return result;
+			}
+			template<class Match>
+			constexpr fragment operator()(const regex<match_named<Match>>& rule)
+			{
+				return (*this)(regex_access::match(rule));
+			}
+		};
+	}
+
+	template<class T, std::size_t States, std::size_t Classes>
+	struct match_dfa_t {};
+
+	// Rows are indexed by byte class rather than by byte, states are stored as
+	// the offset of their row and accepting states come last, so a step is two
+	// loads and acceptance is a single compare. Runs that stay in one state are
+	// consumed by an inner loop whose lookups do not wait on each other.
+	template<class T, std::size_t States, std::size_t Classes>
+	class regex<match_dfa_t<T, States, Classes>>
+	{
+	public:
+		using index_t = regex_index_from_max_value_v<States * Classes>;
+		using class_t = regex_index_from_max_value_v<Classes>;
+		using table_t = std::array<index_t, States * Classes>;
+		using bytes_t = std::array<class_t, 256u>;
+		static constexpr index_t dead = 0;
+	private:
+		table_t table;
+		bytes_t bytes;
+		index_t start;
+		index_t accepts;
+		std::size_t states;
+	public:
+		constexpr regex(const table_t& table, const bytes_t& bytes, index_t start, index_t accepts, std::size_t states) noexcept
+		: table(table), bytes(bytes), start(start), accepts(accepts), states(states)
+		{}
+		regex(regex&&) = default;
+		regex(const regex&) = default;
+		regex& operator=(const regex&) = default;
+		regex& operator=(regex&&) = default;
+	public:
+		using input_type = T;
+		using value_type = match_result_t<T>;
+		using result_t = std::optional<value_type>;
+		class continuation
+		{
+			friend class regex;
+			index_t state;
+			std::uint64_t fed = 0;
+			std::uint64_t accepted = 0;
+		public:
+			constexpr continuation(index_t state, bool accepting) noexcept
+			: state(state), accepted(accepting ? 1 : 0)
+			{}
+		public:
+			constexpr bool done() const noexcept
+			{
+				return state == dead;
+			}
+			constexpr std::uint64_t consumed() const noexcept
+			{
+				return fed;
+			}
+			constexpr std::optional<std::uint64_t> length() const noexcept
+			{
+				if(accepted)
+					return accepted - 1;
+				return std::nullopt;
+			}
+		};
+	public:
+		constexpr std::size_t size() const noexcept
+		{
+			return states;
+		}
+		constexpr index_t initial() const noexcept
+		{
+			return start;
+		}
+		constexpr index_t next(index_t state, T symbol) const noexcept
+		{
+			return table[static_cast<std::size_t>(state) + bytes[regex_byte(symbol)]];
+		}
+		constexpr bool accepting(index_t state) const noexcept
+		{
+			return state >= accepts;
+		}
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			Begin at = it;
+			bool matched = accepting(start);
+			for(index_t state = start; at != end; ) {
+				state = next(state, *at);
+				if(state == dead)
+					break;
+				for(++at; at != end && next(state, *at) == state; ++at);
+				if(accepting(state)) {
+					it = at;
+					matched = true;
+				}
+			}
+			details::regex_end<End>::hit(at, end);
+			return matched;
+		}
+		constexpr continuation resumable() const noexcept
+		{
+			return continuation(start, accepting(start));
+		}
+		template<class Begin, class End>
+		constexpr bool resume(continuation& match, Begin& it, End end) const
+		{
+			// Byte loads may alias the continuation, so it is worked on in locals.
+			Begin at = it;
+			index_t state = match.state;
+			std::uint64_t fed = match.fed;
+			std::uint64_t accepted = match.accepted;
+			while(state != dead && at != end) {
+				state = next(state, *at);
+				if(state == dead)
+					break;
+				for(++at, ++fed; at != end && next(state, *at) == state; ++at, ++fed);
+				if(accepting(state))
+					accepted = fed + 1;
+			}
+			if(state != dead)
+				details::regex_end<End>::hit(at, end);
+			it = at;
+			match.state = state;
+			match.fed = fed;
+			match.accepted = accepted;
+			return state == dead;
+		}
+	public:
+		template<class Begin, class End>
+		constexpr result_t operator()(Begin& it, End end) const
+		{
+			Begin begin = it;
+			if(scan(it, end))
+				return std::make_optional<value_type>(begin, it);
+			return std::nullopt;
+		}
+		template<std::size_t ISize>
+		constexpr result_t operator()(const T(&value)[ISize]) const
+		{
+			auto beging = &value[0];
+			auto end = beging + ISize - 1;
+			if(auto result = (*this)(beging, end)) {
+				if(beging == end)
+					return result;
+			}
+			return std::nullopt;
+		}
+		constexpr const value_type& operator()(const value_type& value) const noexcept
+		{
+			return value;
+		}
+		friend constexpr bool operator==(const regex& a, const regex& b) noexcept
+		{
+			return a.start == b.start && a.accepts == b.accepts && a.states == b.states && a.table == b.table && a.bytes == b.bytes;
+		}
+	};
+
+	namespace details
+	{
+		template<class T, std::size_t States, std::size_t Classes>
+		struct regex_first<regex<match_dfa_t<T, States, Classes>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_dfa_t<T, States, Classes>>& rule) noexcept
+			{
+				regex_lookahead result;
+				result.nullable = rule.accepting(rule.initial());
+				for(std::size_t byte = 0; byte < result.bytes.size(); ++byte)
+					if(rule.next(rule.initial(), static_cast<T>(byte)) != rule.dead)
+						result.bytes.set(byte);
+				return result;
+			}
+		};
+	}
+
+	template<std::size_t States, std::size_t Classes = 256u, class Regex>
+	constexpr auto compile(const regex<Regex>& rule)
+	{
+		using T = regex_input_t<regex<Regex>>;
+		using dfa_t = regex<match_dfa_t<T, States, Classes>>;
+		using index_t = typename dfa_t::index_t;
+		using class_t = typename dfa_t::class_t;
+		constexpr std::size_t positions = regex_positions_v<regex<Regex>>;
+		using set_t = regex_bitset<positions + 1>;
+		static_assert(States >= 2, "dfa needs at least a dead and a start state");
+		static_assert(Classes >= 1 && Classes <= 256u, "dfa byte classes must fit a byte");
+
+		details::regex_glushkov<positions> nfa;
+		const auto root = nfa(rule);
+
+		typename dfa_t::bytes_t bytes{};
+		std::array<std::size_t, Classes> representative{};
+		std::size_t columns = 1;
+		for(std::size_t p = 0; p < nfa.count; ++p) {
+			std::array<std::size_t, Classes * 2u> split{};
+			std::size_t refined = 0;
+			for(std::size_t byte = 0; byte < 256u; ++byte) {
+				auto& target = split[bytes[byte] * 2u + (nfa.symbols[p].test(byte) ? 1 : 0)];
+				if(!target) {
+					if(refined == Classes)
+						throw std::length_error("utils::compile: dfa byte class limit exceeded");
+					representative[refined] = byte;
+					target = ++refined;
+				}
+				bytes[byte] = static_cast<class_t>(target - 1);
+			}
+			columns = refined;
+		}
+
+		std::array<set_t, States> sets{};
+		typename dfa_t::table_t table{};
+		std::array<bool, States> accept{};
+		std::size_t count = 2;
+		sets[1].set(positions);
+		for(std::size_t state = 1; state < count; ++state) {
+			regex_bitset<positions> candidates;
+			if(sets[state].test(positions))
+				candidates |= root.first;
+			for(std::size_t p = 0; p < positions; ++p) {
+				if(sets[state].test(p)) {
+					candidates |= nfa.follow[p];
+					if(root.last.test(p))
+						accept[state] = true;
+				}
+			}
+			if(sets[state].test(positions) && root.nullable)
+				accept[state] = true;
+			for(std::size_t column = 0; column < columns; ++column) {
+				set_t target;
+				for(std::size_t p = 0; p < positions; ++p)
+					if(candidates.test(p) && nfa.symbols[p].test(representative[column]))
+						target.set(p);
+				if(target.none())
+					continue;
+				std::size_t index = 2;
+				while(index < count && sets[index] != target)
+					++index;
+				if(index == count) {
+					if(count == States)
+						throw std::length_error("utils::compile: dfa state limit exceeded");
+					sets[count++] = target;
+				}
+				table[state * Classes + column] = static_cast<index_t>(index);
+			}
+		}
+
+		std::array<std::size_t, States> classes{};
+		std::size_t classes_count = 0;
+		for(std::size_t state = 0; state < count; ++state)
+			classes[state] = accept[state] ? 1 : 0;
+		for(std::size_t previous = 0;;) {
+			std::array<std::size_t, States> refined{};
+			std::size_t refined_count = 0;
+			for(std::size_t state = 0; state < count; ++state) {
+				std::size_t other = 0;
+				for(; other < state; ++other) {
+					bool same = classes[state] == classes[other];
+					for(std::size_t column = 0; same && column < columns; ++column)
+						same = classes[table[state * Classes + column]] == classes[table[other * Classes + column]];
+					if(same)
+						break;
+				}
+				refined[state] = other < state ? refined[other] : refined_count++;
+			}
+			classes = refined;
+			classes_count = refined_count;
+			if(refined_count == previous)
+				break;
+			previous = refined_count;
+		}
+
+		std::array<bool, States> accepting{};
+		for(std::size_t state = 0; state < count; ++state)
+			accepting[classes[state]] = accept[state];
+		std::array<std::size_t, States> order{};
+		std::size_t accepts = 0;
+		for(std::size_t merged = 0; merged < classes_count; ++merged)
+			if(!accepting[merged])
+				order[merged] = accepts++;
+		for(std::size_t merged = 0, numbered = accepts; merged < classes_count; ++merged)
+			if(accepting[merged])
+				order[merged] = numbered++;
+
+		typename dfa_t::table_t minimized{};
+		for(std::size_t state = 0; state < count; ++state)
+			for(std::size_t column = 0; column < columns; ++column)
+				minimized[order[classes[state]] * Classes + column] = static_cast<index_t>(order[classes[table[state * Classes + column]]] * Classes);
+		return dfa_t(minimized, bytes, static_cast<index_t>(order[classes[1]] * Classes), static_cast<index_t>(accepts * Classes), classes_count);
+	}
+
+	template<class Regex>
+	constexpr auto compile(const regex<Regex>& rule)
+	{
+		constexpr std::size_t classes = regex_ranges_v<regex<Regex>> * 2u + 1u;
+		return compile<regex_positions_v<regex<Regex>> * 2u + 2u, classes < 256u ? classes : 256u>(rule);
+	}
+
+}
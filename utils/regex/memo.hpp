@@ -0,0 +1,334 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <utils/regex/regular.hpp>
+#include <utils/regex/dfa.hpp>
+
+namespace utils {
+
+	// Results of memoized rules for one parse, keyed by (rule, position).
+	// Values live in an arena released as a whole when the next parse starts,
+	// so the table and its blocks are reused from one parse to the next.
+	class regex_memo
+	{
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+		struct entry
+		{
+			const void* kind = nullptr;
+			std::size_t id = 0;
+			std::size_t position = 0;
+			std::size_t length = npos;
+			void* value = nullptr;
+		};
+	private:
+		struct slot: entry
+		{
+			std::uint32_t generation = 0;
+		};
+		struct cleanup
+		{
+			void* object;
+			void (*destroy)(void*) noexcept;
+		};
+		static constexpr std::size_t block_size = 16u * 1024u;
+
+		std::vector<slot> slots;
+		std::size_t used = 0;
+		std::uint32_t generation = 1;
+		std::vector<std::unique_ptr<std::byte[]>> blocks;
+		std::vector<std::unique_ptr<std::byte[]>> large;
+		std::size_t current = 0;
+		std::size_t offset = 0;
+		std::vector<cleanup> cleanups;
+	public:
+		regex_memo() = default;
+		regex_memo(const regex_memo&) = delete;
+		regex_memo& operator=(const regex_memo&) = delete;
+		~regex_memo()
+		{
+			release();
+		}
+	private:
+		static std::size_t hash(const void* kind, std::size_t id, std::size_t position) noexcept
+		{
+			auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(kind));
+			value = (value ^ id) * 0x9e3779b97f4a7c15u;
+			value = (value ^ position) * 0xff51afd7ed558ccdu;
+			return static_cast<std::size_t>(value ^ (value >> 32));
+		}
+		slot& locate(const void* kind, std::size_t id, std::size_t position) noexcept
+		{
+			const auto mask = slots.size() - 1;
+			for(auto at = hash(kind, id, position) & mask;; at = (at + 1) & mask) {
+				auto& current = slots[at];
+				if(current.generation != generation || (current.kind == kind && current.id == id && current.position == position))
+					return current;
+			}
+		}
+		void grow()
+		{
+			std::vector<slot> previous(slots.size() ? slots.size() * 2 : 64);
+			previous.swap(slots);
+			for(const auto& old: previous)
+				if(old.generation == generation)
+					locate(old.kind, old.id, old.position) = old;
+		}
+		void* allocate(std::size_t size, std::size_t align)
+		{
+			if(size > block_size / 4)
+				return large.emplace_back(std::make_unique<std::byte[]>(size)).get();
+			auto at = (offset + align - 1) / align * align;
+			if(!current || at + size > block_size) {
+				if(current == blocks.size())
+					blocks.push_back(std::make_unique<std::byte[]>(block_size));
+				++current;
+				at = 0;
+			}
+			offset = at + size;
+			return blocks[current - 1].get() + at;
+		}
+		void release() noexcept
+		{
+			for(auto it = cleanups.rbegin(); it != cleanups.rend(); ++it)
+				it->destroy(it->object);
+			cleanups.clear();
+			large.clear();
+			current = 0;
+			offset = 0;
+		}
+	public:
+		// Forgets every entry; called at the start of each parse.
+		void reset() noexcept
+		{
+			release();
+			used = 0;
+			if(!++generation) {
+				for(auto& current: slots)
+					current.generation = 0;
+				generation = 1;
+			}
+		}
+		std::size_t size() const noexcept
+		{
+			return used;
+		}
+		const entry* find(const void* kind, std::size_t id, std::size_t position) const noexcept
+		{
+			if(!used)
+				return nullptr;
+			const auto& found = const_cast<regex_memo&>(*this).locate(kind, id, position);
+			return found.generation == generation ? &found : nullptr;
+		}
+		entry& insert(const void* kind, std::size_t id, std::size_t position, std::size_t length)
+		{
+			if((used + 1) * 2 > slots.size())
+				grow();
+			auto& found = locate(kind, id, position);
+			if(found.generation != generation) {
+				found = slot{};
+				found.kind = kind;
+				found.id = id;
+				found.position = position;
+				found.generation = generation;
+				++used;
+			}
+			found.length = length;
+			return found;
+		}
+		template<class T>
+		T* store(T&& value)
+		{
+			using type = std::decay_t<T>;
+			static_assert(alignof(type) <= alignof(std::max_align_t), "over-aligned values cannot be memoized");
+			auto object = new(allocate(sizeof(type), alignof(type))) type(std::forward<T>(value));
+			if constexpr(!std::is_trivially_destructible_v<type>)
+				cleanups.push_back(cleanup{object, [](void* object) noexcept {
+					static_cast<type*>(object)->~type();
+				}});
+			return object;
+		}
+	};
+
+	namespace details
+	{
+		template<class Begin>
+		inline constexpr bool regex_memoizable_v = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Begin>::iterator_category>;
+
+		// The table of the parse running on this thread, with the position its
+		// offsets are measured from.
+		template<class Begin>
+		class regex_memo_scope
+		{
+			static inline thread_local regex_memo* active = nullptr;
+			static inline thread_local Begin origin{};
+
+			regex_memo* const outer;
+			const Begin previous;
+		public:
+			regex_memo_scope(regex_memo& memo, const Begin& it) noexcept
+			: outer(active)
+			, previous(origin)
+			{
+				memo.reset();
+				active = &memo;
+				origin = it;
+			}
+			regex_memo_scope(const regex_memo_scope&) = delete;
+			regex_memo_scope& operator=(const regex_memo_scope&) = delete;
+			~regex_memo_scope()
+			{
+				active = outer;
+				origin = previous;
+			}
+		public:
+			static regex_memo* table() noexcept
+			{
+				return active;
+			}
+			static std::size_t position(const Begin& it) noexcept
+			{
+				return static_cast<std::size_t>(it - origin);
+			}
+		};
+	}
+
+	template<class Match>
+	struct match_memo;
+
+	// Copies of a memoized rule share its id; outside utils::scan or
+	// utils::parse with a table the rule matches like its child.
+	template<class Match>
+	class regex<match_memo<Match>>
+	{
+		friend struct details::regex_access;
+		static constexpr char kind = 0;
+		Match match;
+		std::size_t id;
+	public:
+		constexpr regex(std::size_t id, const Match& match) noexcept
+		: match(match)
+		, id(id)
+		{}
+		regex(regex&&) = default;
+		regex(const regex&) = default;
+		regex& operator=(const regex&) = default;
+		regex& operator=(regex&&) = default;
+	public:
+		using value_type = typename Match::value_type;
+		using result_t = typename Match::result_t;
+	public:
+		constexpr std::size_t key() const noexcept
+		{
+			return id;
+		}
+		template<class Begin, class End>
+		bool scan(Begin& it, End end) const
+		{
+			if constexpr(details::regex_memoizable_v<Begin>) {
+				using scope = details::regex_memo_scope<Begin>;
+				if(const auto table = scope::table()) {
+					const auto position = scope::position(it);
+					if(const auto found = table->find(&kind, id, position)) {
+						if(found->length == regex_memo::npos)
+							return false;
+						it += found->length;
+						return true;
+					}
+					const Begin begin = it;
+					const bool matched = match.scan(it, end);
+					table->insert(&kind, id, position, matched ? static_cast<std::size_t>(it - begin) : regex_memo::npos);
+					return matched;
+				}
+			}
+			return match.scan(it, end);
+		}
+		template<class Begin, class End>
+		result_t operator()(Begin& it, End end) const
+		{
+			if constexpr(details::regex_memoizable_v<Begin>) {
+				using scope = details::regex_memo_scope<Begin>;
+				if(const auto table = scope::table()) {
+					const auto position = scope::position(it);
+					const auto found = table->find(&kind, id, position);
+					if(found && found->length == regex_memo::npos)
+						return result_t{};
+					if(found && found->value) {
+						it += found->length;
+						return *static_cast<const result_t*>(found->value);
+					}
+					const Begin begin = it;
+					auto result = match(it, end);
+					auto& entry = table->insert(&kind, id, position, result ? static_cast<std::size_t>(it - begin) : regex_memo::npos);
+					if(result)
+						entry.value = table->store(result_t(result));
+					return result;
+				}
+			}
+			return match(it, end);
+		}
+		template<class T, std::size_t Size>
+		result_t operator()(const T(&value)[Size]) const
+		{
+			auto begin = &value[0];
+			auto end = begin + Size - 1;
+			if(auto result = (*this)(begin, end)) {
+				if(begin == end)
+					return result;
+			}
+			return result_t{};
+		}
+		constexpr auto operator()(const value_type& value) const
+		{
+			return match(value);
+		}
+		friend constexpr bool operator==(const regex& a, const regex& b) noexcept
+		{
+			return a.id == b.id && a.match == b.match;
+		}
+	};
+
+	template<class Match>
+	constexpr auto memo(std::size_t id, regex<Match> match) noexcept
+	{
+		return regex<match_memo<regex<Match>>>(id, std::move(match));
+	}
+
+	template<class Match>
+	struct regex_input<regex<match_memo<Match>>>: regex_input<Match> {};
+
+	namespace details
+	{
+		template<class Match>
+		struct regex_first<regex<match_memo<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_memo<Match>>& rule) noexcept
+			{
+				return regex_first<Match>::lookahead(regex_access::match(rule));
+			}
+		};
+	}
+
+	template<class Regex, class Begin, class End>
+	bool scan(const regex<Regex>& rule, Begin& it, const End& end, regex_memo& memo)
+	{
+		static_assert(details::regex_memoizable_v<Begin>, "memoized parsing needs random access input");
+		details::regex_memo_scope<Begin> scope(memo, it);
+		return rule.scan(it, end);
+	}
+
+	template<class Regex, class Begin, class End>
+	auto parse(const regex<Regex>& rule, Begin& it, const End& end, regex_memo& memo)
+	{
+		static_assert(details::regex_memoizable_v<Begin>, "memoized parsing needs random access input");
+		details::regex_memo_scope<Begin> scope(memo, it);
+		return rule(it, end);
+	}
+
+}
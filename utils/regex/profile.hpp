@@ -0,0 +1,363 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <utils/demangler.hpp>
+#include <utils/regex/regular.hpp>
+
+namespace utils {
+
+	struct regex_counters
+	{
+		std::uint64_t attempts = 0;
+		std::uint64_t successes = 0;
+		std::uint64_t consumed = 0;
+		std::uint64_t examined = 0;
+	};
+
+	// Counters are plain integers: profile a rule from one thread at a time.
+	class regex_profile
+	{
+	public:
+		struct entry
+		{
+			std::string label;
+			std::size_t depth;
+			regex_counters counters;
+		};
+	private:
+		std::deque<entry> entries;
+	public:
+		regex_profile() = default;
+		regex_profile(const regex_profile&) = delete;
+		regex_profile& operator=(const regex_profile&) = delete;
+	public:
+		regex_counters& add(std::string label, std::size_t depth)
+		{
+			return entries.emplace_back(entry{std::move(label), depth, {}}).counters;
+		}
+		void reset() noexcept
+		{
+			for(auto& entry: entries)
+				entry.counters = {};
+		}
+		auto begin() const noexcept
+		{
+			return entries.begin();
+		}
+		auto end() const noexcept
+		{
+			return entries.end();
+		}
+		std::size_t size() const noexcept
+		{
+			return entries.size();
+		}
+		const entry& operator[](std::size_t index) const noexcept
+		{
+			return entries[index];
+		}
+		friend std::ostream& operator<<(std::ostream& stream, const regex_profile& profile)
+		{
+			stream << std::setw(12) << "attempts" << std::setw(12) << "successes" << std::setw(14) << "consumed" << std::setw(14) << "examined" << "  rule\n";
+			for(const auto& entry: profile.entries) {
+				const auto& counters = entry.counters;
+				stream << std::setw(12) << counters.attempts << std::setw(12) << counters.successes << std::setw(14) << counters.consumed
+					<< std::setw(14) << counters.examined << "  " << std::string(entry.depth * 2, ' ') << entry.label << '\n';
+			}
+			return stream;
+		}
+	};
+
+	namespace details
+	{
+		// Positions are measured from the outermost profiled node, so a failing
+		// node can tell how far its descendants looked before giving up.
+		template<class Begin>
+		class regex_probe
+		{
+			static constexpr bool measurable = std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Begin>::iterator_category>;
+			static inline thread_local bool active = false;
+			static inline thread_local Begin origin{};
+			static inline thread_local std::ptrdiff_t reach = 0;
+
+			regex_counters& counters;
+			const Begin begin;
+			const bool root;
+			std::ptrdiff_t outer = 0;
+		private:
+			static std::ptrdiff_t offset(const Begin& it) noexcept
+			{
+				return it - origin;
+			}
+		public:
+			regex_probe(regex_counters& counters, const Begin& it) noexcept
+			: counters(counters)
+			, begin(it)
+			, root(!active)
+			{
+				++counters.attempts;
+				if constexpr(measurable) {
+					if(root) {
+						active = true;
+						origin = it;
+						reach = 0;
+					}
+					outer = reach;
+					reach = offset(it);
+				}
+			}
+			regex_probe(const regex_probe&) = delete;
+			regex_probe& operator=(const regex_probe&) = delete;
+			~regex_probe()
+			{
+				if constexpr(measurable) {
+					reach = std::max(outer, reach);
+					if(root)
+						active = false;
+				}
+			}
+		public:
+			template<class End>
+			bool operator()(bool matched, const Begin& it, const End& end) noexcept
+			{
+				if(matched) {
+					++counters.successes;
+					counters.consumed += static_cast<std::uint64_t>(std::distance(begin, it));
+					if constexpr(measurable)
+						reach = std::max(reach, offset(it));
+				} else if constexpr(measurable) {
+					const auto start = offset(begin);
+					if(begin != regex_end<End>::get(end))
+						reach = std::max(reach, start + 1);
+					counters.examined += static_cast<std::uint64_t>(reach - start);
+				}
+				return matched;
+			}
+		};
+	}
+
+	template<class Match>
+	struct match_profiled;
+
+	template<class Match>
+	class regex<match_profiled<Match>>
+	{
+		friend struct details::regex_access;
+		Match match;
+		regex_counters* counters;
+	public:
+		regex(const Match& match, regex_counters& counters) noexcept
+		: match(match)
+		, counters(&counters)
+		{}
+		regex(regex&&) = default;
+		regex(const regex&) = default;
+		regex& operator=(const regex&) = default;
+		regex& operator=(regex&&) = default;
+	public:
+		using value_type = typename Match::value_type;
+		using result_t = typename Match::result_t;
+	public:
+		template<class Begin, class End>
+		bool scan(Begin& it, End end) const
+		{
+			details::regex_probe<Begin> probe(*counters, it);
+			return probe(match.scan(it, end), it, end);
+		}
+		template<class Begin, class End>
+		result_t operator()(Begin& it, End end) const
+		{
+			details::regex_probe<Begin> probe(*counters, it);
+			auto result = match(it, end);
+			probe(static_cast<bool>(result), it, end);
+			return result;
+		}
+		template<class T, std::size_t Size>
+		result_t operator()(const T(&value)[Size]) const
+		{
+			auto begin = &value[0];
+			auto end = begin + Size - 1;
+			if(auto result = (*this)(begin, end)) {
+				if(begin == end)
+					return result;
+			}
+			return std::nullopt;
+		}
+		friend bool operator==(const regex& a, const regex& b) noexcept
+		{
+			return a.match == b.match;
+		}
+	};
+
+	namespace details
+	{
+		template<class Match>
+		struct regex_class<regex<match_profiled<Match>>>: regex_class_forward<regex<match_profiled<Match>>, Match> {};
+
+		template<class Match>
+		struct regex_first<regex<match_profiled<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_profiled<Match>>& rule) noexcept
+			{
+				return regex_first<Match>::lookahead(regex_access::match(rule));
+			}
+		};
+
+		inline std::string regex_quote(const char* values, std::size_t size, char open, char close)
+		{
+			const char digits[] = "0123456789abcdef";
+			std::string text(1, open);
+			for(std::size_t i = 0; i < size; ++i) {
+				const auto byte = static_cast<unsigned char>(values[i]);
+				if(byte < 0x20 || byte >= 0x7f || byte == '\\' || byte == static_cast<unsigned char>(close)) {
+					text += "\\x";
+					text += digits[byte >> 4];
+					text += digits[byte & 0xf];
+				} else {
+					text += static_cast<char>(byte);
+				}
+			}
+			return text + close;
+		}
+
+		template<class Regex>
+		std::string regex_kind()
+		{
+			auto kind = demangle(typeid(Regex).name());
+			const auto open = kind.find('<');
+			if(open != std::string::npos)
+				kind = kind.substr(open + 1, kind.find_first_of("<>", open + 1) - open - 1);
+			if(kind.rfind("utils::", 0) == 0)
+				kind.erase(0, 7);
+			return kind;
+		}
+
+		template<class Regex>
+		std::string regex_label(const Regex&)
+		{
+			return regex_kind<Regex>();
+		}
+
+		template<std::size_t Size>
+		std::string regex_label(const regex<match_sequence_t<char, Size>>& rule)
+		{
+			return regex_kind<regex<match_sequence_t<char, Size>>>() + ' ' + regex_quote(regex_access::values(rule).data(), Size, '"', '"');
+		}
+
+		template<std::size_t Size>
+		std::string regex_label(const regex<match_anyof_t<char, Size>>& rule)
+		{
+			return regex_kind<regex<match_anyof_t<char, Size>>>() + ' ' + regex_quote(regex_access::values(rule).data(), Size, '[', ']');
+		}
+
+		template<std::size_t Count, std::size_t Capacity>
+		std::string regex_label(const regex<match_literals_t<char, Count, Capacity>>& rule)
+		{
+			const auto& values = regex_access::values(rule);
+			const auto& offsets = regex_access::offsets(rule);
+			auto label = regex_kind<regex<match_literals_t<char, Count, Capacity>>>();
+			for(std::size_t i = 0; i < Count; ++i)
+				label += ' ' + regex_quote(values.data() + offsets[i], offsets[i + 1] - offsets[i], '"', '"');
+			return label;
+		}
+
+		inline std::string regex_label(const regex<match_range_t<char>>& rule)
+		{
+			return regex_kind<regex<match_range_t<char>>>() + ' ' + regex_quote(&regex_access::from(rule), 1, '\'', '\'')
+				+ '-' + regex_quote(&regex_access::to(rule), 1, '\'', '\'');
+		}
+
+		template<class Regex>
+		struct regex_profiler
+		{
+			static auto wrap(const Regex& rule, regex_profile& profile, std::size_t depth, std::string label = {})
+			{
+				auto& counters = profile.add(label.empty() ? regex_label(rule) : std::move(label), depth);
+				return regex<match_profiled<Regex>>(rule, counters);
+			}
+		};
+
+		template<template<class...> class Node, class ...Regexs>
+		struct regex_profiler_node
+		{
+			template<class Children, std::size_t... I>
+			static auto wrap(const regex<Node<Regexs...>>& rule, const Children& children, regex_profile& profile, std::size_t depth, std::string label, std::index_sequence<I...>)
+			{
+				auto& counters = profile.add(label.empty() ? regex_label(rule) : std::move(label), depth);
+				using node_t = regex<Node<decltype(regex_profiler<Regexs>::wrap(std::declval<const Regexs&>(), profile, depth))...>>;
+				return regex<match_profiled<node_t>>(node_t{regex_profiler<Regexs>::wrap(std::get<I>(children), profile, depth + 1)...}, counters);
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_profiler<regex<match_or_t<Regexs...>>>: regex_profiler_node<match_or_t, Regexs...>
+		{
+			static auto wrap(const regex<match_or_t<Regexs...>>& rule, regex_profile& profile, std::size_t depth, std::string label = {})
+			{
+				return regex_profiler_node<match_or_t, Regexs...>::wrap(rule, regex_access::matchs(rule), profile, depth, std::move(label), std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_profiler<regex<match_and_t<Regexs...>>>: regex_profiler_node<match_and_t, Regexs...>
+		{
+			static auto wrap(const regex<match_and_t<Regexs...>>& rule, regex_profile& profile, std::size_t depth, std::string label = {})
+			{
+				return regex_profiler_node<match_and_t, Regexs...>::wrap(rule, regex_access::matchs(rule), profile, depth, std::move(label), std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<template<class> class Node, class Match>
+		struct regex_profiler_unary: regex_profiler_node<Node, Match>
+		{
+			static auto wrap(const regex<Node<Match>>& rule, regex_profile& profile, std::size_t depth, std::string label = {})
+			{
+				return regex_profiler_node<Node, Match>::wrap(rule, std::tie(regex_access::match(rule)), profile, depth, std::move(label), std::index_sequence<0>());
+			}
+		};
+
+		template<class Match>
+		struct regex_profiler<regex<match_zero_plus<Match>>>: regex_profiler_unary<match_zero_plus, Match> {};
+
+		template<class Match>
+		struct regex_profiler<regex<match_one_plus<Match>>>: regex_profiler_unary<match_one_plus, Match> {};
+
+		template<class Match>
+		struct regex_profiler<regex<match_optional<Match>>>: regex_profiler_unary<match_optional, Match> {};
+
+		template<class Match>
+		struct regex_profiler<regex<match_named<Match>>>
+		{
+			static auto wrap(const regex<match_named<Match>>& rule, regex_profile& profile, std::size_t depth, std::string label = {})
+			{
+				return regex_profiler<Match>::wrap(regex_access::match(rule), profile, depth, label.empty() ? std::string(rule.label()) : std::move(label));
+			}
+		};
+	}
+
+	template<class Regex>
+	auto instrument(const regex<Regex>& rule, regex_profile& report)
+	{
+		return details::regex_profiler<regex<Regex>>::wrap(rule, report, 0);
+	}
+
+	template<class Regex>
+	constexpr auto profile(const regex<Regex>& rule, [[maybe_unused]] regex_profile& report)
+	{
+#if defined(UTILS_REGEX_PROFILE)
+		return instrument(rule, report);
+#else
+		return rule;
+#endif
+	}
+
+}
@@ -5,13 +5,89 @@
 #include <optional>
 #include <variant>
 #include <algorithm>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <limits>
 #include <utils/tag.hpp>
+#include <utils/regex/bitset.hpp>
+#include <utils/regex/bound.hpp>
+#include <utils/regex/simd.hpp>
+#include <utils/regex/trie.hpp>
 
 namespace utils {
 
 	template<class T>
 	class regex;
 
+	namespace details
+	{
+		struct regex_access
+		{
+			template<class Regex>
+			static constexpr const auto& values(const Regex& regex) noexcept
+			{
+				return regex.values;
+			}
+			template<class Regex>
+			static constexpr const auto& from(const Regex& regex) noexcept
+			{
+				return regex.from;
+			}
+			template<class Regex>
+			static constexpr const auto& to(const Regex& regex) noexcept
+			{
+				return regex.to;
+			}
+			template<class Regex>
+			static constexpr const auto& matchs(const Regex& regex) noexcept
+			{
+				return regex.matchs;
+			}
+			template<class Regex>
+			static constexpr const auto& match(const Regex& regex) noexcept
+			{
+				return regex.match;
+			}
+			template<class Regex>
+			static constexpr const auto& offsets(const Regex& regex) noexcept
+			{
+				return regex.offsets;
+			}
+			template<class Regex>
+			static constexpr const auto& lookahead(const Regex& regex) noexcept
+			{
+				return regex.lookahead;
+			}
+		};
+	}
+
+	struct regex_lookahead
+	{
+		regex_byteset bytes;
+		bool nullable = false;
+	};
+
+	namespace details
+	{
+		constexpr regex_lookahead regex_unknown_lookahead() noexcept
+		{
+			regex_lookahead result;
+			result.bytes.flip();
+			result.nullable = true;
+			return result;
+		}
+
+		template<class Regex>
+		struct regex_first
+		{
+			static constexpr regex_lookahead lookahead(const Regex&) noexcept
+			{
+				return regex_unknown_lookahead();
+			}
+		};
+	}
+
 	template<class T>
 	struct match_result
 	{
@@ -33,6 +109,7 @@ namespace utils {
 	template<class T, std::size_t Size>
 	class regex<match_sequence_t<T, Size>>
 	{
+		friend struct details::regex_access;
 		std::array<T, Size> values;
 	public:
 		template<std::size_t... I>
@@ -62,6 +139,18 @@ namespace utils {
 			}
 		};
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			Begin vit = it;
+			for(const auto& value: values) {
+				if(details::regex_end<End>::hit(vit, end) || *vit != value)
+					return false;
+				++vit;
+			}
+			it = vit;
+			return true;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End vend) const
 		{
@@ -78,6 +167,7 @@ namespace utils {
 				it += Size;
 				return result_t{true};
 			}
+			details::regex_end<End>::hit(vit, vend);
 			return result_t{false};
 		}
 		template<std::size_t ISize>
@@ -139,6 +229,7 @@ namespace utils {
 	template<class T, std::size_t Size>
 	class regex<match_anyof_t<T, Size>>
 	{
+		friend struct details::regex_access;
 		using index_t = regex_index_from_max_value_v<Size>;
 		std::array<T, Size> values;
 	public:
@@ -169,12 +260,25 @@ namespace utils {
 			}
 		};
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			if(!details::regex_end<End>::hit(it, end)) {
+				for(const auto& value: values) {
+					if(value == *it) {
+						++it;
+						return true;
+					}
+				}
+			}
+			return false;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
 			const auto mbegin = values.begin();
 			const auto mend = values.end();
-			if(it != end)
+			if(!details::regex_end<End>::hit(it, end))
 			{
 				for(index_t i = 0; i < Size; ++i) {
 					if(values[i] == *it) {
@@ -232,6 +336,7 @@ namespace utils {
 	template<class T>
 	class regex<match_range_t<T>>
 	{
+		friend struct details::regex_access;
 		T from, to;
 	public:
 		constexpr regex(T from, T to) noexcept
@@ -246,10 +351,21 @@ namespace utils {
 		using value_type = T;
 		using result_t = std::optional<T>;
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			if(!details::regex_end<End>::hit(it, end)) {
+				if(const T symbol = *it; symbol >= from && symbol <= to) {
+					++it;
+					return true;
+				}
+			}
+			return false;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
-			if(it != end)
+			if(!details::regex_end<End>::hit(it, end))
 			{
 				if(T symbol = *it; symbol >= from && symbol <= to)
 				{
@@ -293,6 +409,108 @@ namespace utils {
 		}
 	};
 
+	template<class T, std::size_t Count, std::size_t Capacity>
+	struct match_literals_t {};
+
+	template<class T, std::size_t Count, std::size_t Capacity>
+	class regex<match_literals_t<T, Count, Capacity>>
+	{
+		static_assert(sizeof(T) == 1, "literal sets are matched byte by byte");
+		friend struct details::regex_access;
+		using index_t = regex_index_from_max_value_v<Count>;
+		std::array<T, Capacity> values{};
+		std::array<std::size_t, Count + 1> offsets{};
+		regex_trie<Capacity> trie;
+	private:
+		constexpr void add(std::size_t index, const T* literal, std::size_t size) noexcept
+		{
+			offsets[index + 1] = offsets[index] + size;
+			for(std::size_t i = 0; i < size; ++i)
+				values[offsets[index] + i] = literal[i];
+			trie.insert(0, literal, size, index);
+		}
+	public:
+		template<std::size_t... Sizes>
+		constexpr regex(const T(&...literals)[Sizes]) noexcept
+		{
+			static_assert(sizeof...(Sizes) == Count && ((Sizes > 1) && ...), "literals must not be empty");
+			std::size_t index = 0;
+			(add(index++, literals, Sizes - 1), ...);
+		}
+		regex(regex&&) = default;
+		regex(const regex&) = default;
+		regex& operator=(const regex&) = default;
+		regex& operator=(regex&&) = default;
+	public:
+		using input_type = T;
+		using value_type = index_t;
+		struct result_t
+		{
+			value_type value = Count;
+			operator bool() const noexcept
+			{
+				return value < Count;
+			}
+			value_type operator*() const noexcept
+			{
+				return value;
+			}
+		};
+	public:
+		static constexpr std::size_t size() noexcept
+		{
+			return Count;
+		}
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			return trie.template find<true>(0, it, end) != trie.npos;
+		}
+		template<class Begin, class End>
+		constexpr result_t operator()(Begin& it, End end) const
+		{
+			const auto index = trie.template find<true>(0, it, end);
+			return result_t{static_cast<index_t>(index == trie.npos ? Count : index)};
+		}
+		template<std::size_t ISize>
+		constexpr result_t operator()(const T(&value)[ISize]) const
+		{
+			auto beging = &value[0];
+			auto end = beging + ISize - 1;
+			if(auto result = (*this)(beging, end)) {
+				if(beging == end)
+					return result;
+			}
+			return result_t{};
+		}
+		constexpr auto operator()(value_type index) const
+		{
+			return match_result_t<T>(values.begin() + offsets[index], values.begin() + offsets[index + 1]);
+		}
+		template<class Regex>
+		constexpr auto operator()(const value_type& value, const regex<Regex>& subrule) const
+		{
+			return match_result_t<T>();
+		}
+		constexpr match_result_t<T> operator()(const value_type& value, const regex& subrule) const
+		{
+			if(subrule == *this)
+				return subrule(value);
+			return {};
+		}
+		friend constexpr bool operator==(const regex& a, const regex& b) noexcept
+		{
+			return a.offsets == b.offsets && a.values == b.values;
+		}
+	};
+
+	// Longest match wins; the value is the index of the literal in the list.
+	template<class T, std::size_t... Sizes>
+	constexpr auto literals(const T(&...values)[Sizes]) noexcept
+	{
+		return regex<match_literals_t<T, sizeof...(Sizes), (0 + ... + (Sizes - 1))>>(values...);
+	}
+
 	struct match_t
 	{
 		template<class T, std::size_t Size>
@@ -323,6 +541,48 @@ namespace utils {
 		class regex_matchs_concat;
 		template<class ARegexs, class BRegexs>
 		struct visitor;
+		template<class Regex>
+		struct regex_class;
+
+		enum class regex_merge: std::uint8_t { none, byteclass, literal, either };
+
+		template<class Regex>
+		struct regex_mergeable: std::integral_constant<regex_merge, regex_class<Regex>::value ? regex_merge::byteclass : regex_merge::none> {};
+
+		template<class T, std::size_t Size>
+		struct regex_mergeable<regex<match_sequence_t<T, Size>>>: std::integral_constant<regex_merge,
+			sizeof(T) != 1 || Size == 0 ? regex_merge::none : Size == 1 ? regex_merge::either : regex_merge::literal
+		> {};
+
+		template<class Regex>
+		struct regex_literal_size: std::integral_constant<std::size_t, 0> {};
+
+		template<class T, std::size_t Size>
+		struct regex_literal_size<regex<match_sequence_t<T, Size>>>: std::integral_constant<std::size_t, Size> {};
+
+		// Adjacent alternatives that are all byte classes, or all literals, are
+		// matched as one group; a single byte literal joins its neighbours.
+		template<std::size_t Size>
+		constexpr std::array<regex_merge, Size> regex_merge_plan(std::array<regex_merge, Size> kinds) noexcept
+		{
+			for(std::size_t i = 0; i < Size; ++i) {
+				if(kinds[i] != regex_merge::either)
+					continue;
+				if(i > 0 && kinds[i - 1] != regex_merge::none) {
+					kinds[i] = kinds[i - 1];
+					continue;
+				}
+				std::size_t next = i + 1;
+				while(next < Size && kinds[next] == regex_merge::either)
+					++next;
+				kinds[i] = next < Size && kinds[next] == regex_merge::literal ? regex_merge::literal : regex_merge::byteclass;
+			}
+			auto plan = kinds;
+			for(std::size_t i = 0; i < Size; ++i)
+				if(!(i > 0 && kinds[i - 1] == kinds[i]) && !(i + 1 < Size && kinds[i + 1] == kinds[i]))
+					plan[i] = regex_merge::none;
+			return plan;
+		}
 	}
 
 	template<class ...Regexs, std::size_t... Is>
@@ -342,8 +602,43 @@ namespace utils {
 		friend class details::regex_matchs_concat;
 		template<class ARegexs, class BRegexs>
 		friend class details::visitor;
-		
+		friend struct details::regex_access;
+
+		static constexpr std::size_t size = sizeof...(Regexs);
+		static constexpr auto merges = details::regex_merge_plan<size>({details::regex_mergeable<Regexs>::value...});
+
+		static constexpr bool leads(std::size_t i) noexcept
+		{
+			return merges[i] != details::regex_merge::none && (i == 0 || merges[i - 1] != merges[i]);
+		}
+		static constexpr std::size_t last(std::size_t i) noexcept
+		{
+			while(i + 1 < size && merges[i + 1] == merges[i])
+				++i;
+			return i;
+		}
+		static constexpr std::size_t groups(details::regex_merge kind, std::size_t end = size) noexcept
+		{
+			std::size_t result = 0;
+			for(std::size_t i = 0; i < end; ++i)
+				result += merges[i] == kind && leads(i);
+			return result;
+		}
+		static constexpr std::size_t group(std::size_t i) noexcept
+		{
+			return groups(merges[i], i + 1) - 1;
+		}
+		static constexpr std::size_t capacity = groups(details::regex_merge::literal) ? (details::regex_literal_size<Regexs>::value + ...) : 0;
+
+		struct merged_t
+		{
+			std::array<regex_byteset, groups(details::regex_merge::byteclass)> sets{};
+			regex_trie<capacity, groups(details::regex_merge::literal)> trie;
+		};
+
 		std::tuple<Regexs...> matchs;
+		std::array<regex_lookahead, size> lookahead;
+		merged_t merged;
 	public:
 		regex(regex&&) = default;
 		regex(const regex&) = default;
@@ -353,29 +648,130 @@ namespace utils {
 		template<class ...IRegexs>
 		constexpr regex(const regex<IRegexs>& ...matchs) noexcept
 		: matchs(matchs...)
+		, lookahead{details::regex_first<regex<IRegexs>>::lookahead(matchs)...}
+		, merged(merge(std::make_index_sequence<size>()))
 		{}
 		using value_type = typename regex<match_or_t<std::tuple<Regexs...>, std::make_index_sequence<sizeof...(Regexs)>>>::value_type;
 		using result_t = std::optional<value_type>;
 	private:
-		template<class Begin, class End, std::size_t I>
-		constexpr result_t operator()(Begin& it, End end, const std::index_sequence<I>&) const
+		template<std::size_t I>
+		constexpr void merge(merged_t& result) const noexcept
+		{
+			using type = std::tuple_element_t<I, std::tuple<Regexs...>>;
+			if constexpr(merges[I] == details::regex_merge::byteclass) {
+				result.sets[group(I)] |= details::regex_class<type>::set(std::get<I>(matchs));
+			} else if constexpr(merges[I] == details::regex_merge::literal) {
+				const auto& values = details::regex_access::values(std::get<I>(matchs));
+				result.trie.insert(group(I), values.data(), values.size(), I);
+			}
+		}
+		template<std::size_t... I>
+		constexpr merged_t merge(std::index_sequence<I...>) const noexcept
+		{
+			merged_t result{};
+			(merge<I>(result), ...);
+			return result;
+		}
+		template<std::size_t I, class Begin>
+		static constexpr bool merged_v = merges[I] != details::regex_merge::none && sizeof(*std::declval<Begin&>()) == 1;
+
+		template<std::size_t I, class Begin, class End>
+		constexpr bool viable(const Begin& it, const End& end) const
 		{
+			if(lookahead[I].nullable)
+				return true;
+			if constexpr(sizeof(*it) == 1)
+				return !details::regex_end<End>::hit(it, end) && lookahead[I].bytes.test(regex_byte(*it));
+			return true;
+		}
+		template<std::size_t I, class Begin, class End>
+		constexpr result_t attempt(Begin& it, End end) const
+		{
+			Begin begin = it;
 			if(auto result = std::get<I>(matchs)(it, end))
 				return std::make_optional<value_type>(std::in_place_index<I>, *std::move(result));
+			it = begin;
 			return std::nullopt;
 		}
-		template<class Begin, class End, std::size_t I, std::size_t... Is>
-		constexpr result_t operator()(Begin& it, End end, const std::index_sequence<I, Is...>&) const
+		template<std::size_t I>
+		static constexpr bool emit(std::size_t index, result_t& result) noexcept
 		{
-			if(auto result = std::get<I>(matchs)(it, end))
-				return std::make_optional<value_type>(std::in_place_index<I>, *std::move(result));
-			return (*this)(it, end, std::index_sequence<Is...>());
+			if constexpr(merges[I] == details::regex_merge::literal) {
+				if(index == I) {
+					result.emplace(std::in_place_index<I>, typename std::tuple_element_t<I, std::tuple<Regexs...>>::value_type{});
+					return true;
+				}
+			}
+			return false;
+		}
+		template<std::size_t... I>
+		static constexpr result_t emit(std::size_t index, std::index_sequence<I...>) noexcept
+		{
+			result_t result;
+			static_cast<void>((emit<I>(index, result) || ...));
+			return result;
+		}
+		template<std::size_t I, class Begin, class End>
+		constexpr result_t match(Begin& it, End end) const
+		{
+			if constexpr(I == size) {
+				return std::nullopt;
+			} else if constexpr(merged_v<I, Begin> && merges[I] == details::regex_merge::literal) {
+				if(const auto index = merged.trie.template find<false>(group(I), it, end); index != merged.trie.npos)
+					return emit(index, std::make_index_sequence<size>());
+				return match<last(I) + 1>(it, end);
+			} else {
+				if constexpr(merged_v<I, Begin> && leads(I)) {
+					if(details::regex_end<End>::hit(it, end) || !merged.sets[group(I)].test(regex_byte(*it)))
+						return match<last(I) + 1>(it, end);
+				}
+				if(viable<I>(it, end)) {
+					if(auto result = attempt<I>(it, end))
+						return result;
+				}
+				return match<I + 1>(it, end);
+			}
+		}
+		template<std::size_t I, class Begin, class End>
+		constexpr bool scan(Begin& it, End end, const Begin& begin) const
+		{
+			if constexpr(merged_v<I, Begin>) {
+				if constexpr(!leads(I)) {
+					return false;
+				} else if constexpr(merges[I] == details::regex_merge::byteclass) {
+					if(!details::regex_end<End>::hit(it, end) && merged.sets[group(I)].test(regex_byte(*it))) {
+						++it;
+						return true;
+					}
+					return false;
+				} else {
+					return merged.trie.template find<false>(group(I), it, end) != merged.trie.npos;
+				}
+			} else {
+				if(viable<I>(it, end)) {
+					if(std::get<I>(matchs).scan(it, end))
+						return true;
+					it = begin;
+				}
+				return false;
+			}
+		}
+		template<class Begin, class End, std::size_t... I>
+		constexpr bool scan(Begin& it, End end, const std::index_sequence<I...>&) const
+		{
+			const Begin begin = it;
+			return (scan<I>(it, end, begin) || ...);
 		}
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			return scan(it, end, std::make_index_sequence<sizeof...(Regexs)>());
+		}
 		template<class Begin, class End>
 		constexpr auto operator()(Begin& it, End end) const
 		{
-			return (*this)(it, end, std::make_index_sequence<sizeof...(Regexs)>());
+			return match<0>(it, end);
 		}
 		template<class T, std::size_t Size>
 		constexpr result_t operator()(const T(&value)[Size]) const
@@ -509,7 +905,8 @@ namespace utils {
 	{
 		template<class ARegexs, class BRegexs>
 		friend class details::regex_matchs_concat;
-		
+		friend struct details::regex_access;
+
 		std::tuple<Regexs...> matchs;
 	public:
 		regex(regex&&) = default;
@@ -545,11 +942,29 @@ namespace utils {
 			}
 			return std::nullopt;
 		}
+		template<class Begin, class End, std::size_t... I>
+		constexpr bool scan(Begin& it, End end, const std::index_sequence<I...>&) const
+		{
+			return (std::get<I>(matchs).scan(it, end) && ...);
+		}
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			Begin begin = it;
+			if(scan(it, end, std::make_index_sequence<sizeof...(Regexs)>()))
+				return true;
+			it = begin;
+			return false;
+		}
 		template<class Begin, class End>
 		constexpr auto operator()(Begin& it, End end) const
 		{
-			return (*this)(it, end, std::make_index_sequence<sizeof...(Regexs)>());
+			Begin begin = it;
+			auto result = (*this)(it, end, std::make_index_sequence<sizeof...(Regexs)>());
+			if(!result)
+				it = begin;
+			return result;
 		}
 	public:
 		template<class T, std::size_t Size>
@@ -702,16 +1117,214 @@ namespace utils {
 		return match(a) & b;
 	}
 
+	namespace details
+	{
+		template<class Regex>
+		struct regex_class_none: std::false_type
+		{
+			static constexpr std::tuple<> byteclass(const Regex&) noexcept
+			{
+				return {};
+			}
+		};
+
+		template<class Regex>
+		struct regex_class: regex_class_none<Regex> {};
+
+		template<class Regex>
+		struct regex_class_base: std::true_type
+		{
+			static constexpr regex_byteclass byteclass(const Regex& rule) noexcept
+			{
+				return regex_byteclass(regex_class<Regex>::set(rule));
+			}
+		};
+
+		template<class T>
+		struct regex_class<regex<match_sequence_t<T, 1>>>: regex_class_base<regex<match_sequence_t<T, 1>>>
+		{
+			static constexpr regex_byteset set(const regex<match_sequence_t<T, 1>>& rule) noexcept
+			{
+				return regex_byteset().set(regex_byte(regex_access::values(rule)[0]));
+			}
+		};
+
+		template<class T, std::size_t Size>
+		struct regex_class<regex<match_anyof_t<T, Size>>>: regex_class_base<regex<match_anyof_t<T, Size>>>
+		{
+			static constexpr regex_byteset set(const regex<match_anyof_t<T, Size>>& rule) noexcept
+			{
+				regex_byteset result;
+				for(const auto& value: regex_access::values(rule))
+					result.set(regex_byte(value));
+				return result;
+			}
+		};
+
+		template<class T>
+		struct regex_class<regex<match_range_t<T>>>: regex_class_base<regex<match_range_t<T>>>
+		{
+			static constexpr regex_byteset set(const regex<match_range_t<T>>& rule) noexcept
+			{
+				regex_byteset result;
+				for(std::size_t byte = 0; byte < result.size(); ++byte) {
+					const auto value = static_cast<T>(byte);
+					if(value >= regex_access::from(rule) && value <= regex_access::to(rule))
+						result.set(byte);
+				}
+				return result;
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_class_or: regex_class_base<regex<match_or_t<Regexs...>>>
+		{
+			template<std::size_t... I>
+			static constexpr regex_byteset set(const regex<match_or_t<Regexs...>>& rule, std::index_sequence<I...>) noexcept
+			{
+				return (regex_byteset() | ... | regex_class<Regexs>::set(std::get<I>(regex_access::matchs(rule))));
+			}
+			static constexpr regex_byteset set(const regex<match_or_t<Regexs...>>& rule) noexcept
+			{
+				return set(rule, std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_class<regex<match_or_t<Regexs...>>>: std::conditional_t<
+			(regex_class<Regexs>::value && ...),
+			regex_class_or<Regexs...>,
+			regex_class_none<regex<match_or_t<Regexs...>>>
+		>
+		{};
+
+		template<class T, std::size_t Size>
+		struct regex_first<regex<match_sequence_t<T, Size>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_sequence_t<T, Size>>& rule) noexcept
+			{
+				regex_lookahead result;
+				if constexpr(Size == 0)
+					result.nullable = true;
+				else if constexpr(sizeof(T) == 1)
+					result.bytes.set(regex_byte(regex_access::values(rule)[0]));
+				else
+					return regex_unknown_lookahead();
+				return result;
+			}
+		};
+
+		template<class T, std::size_t Size>
+		struct regex_first<regex<match_anyof_t<T, Size>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_anyof_t<T, Size>>& rule) noexcept
+			{
+				if constexpr(sizeof(T) == 1)
+					return regex_lookahead{regex_class<regex<match_anyof_t<T, Size>>>::set(rule), false};
+				else
+					return regex_unknown_lookahead();
+			}
+		};
+
+		template<class T>
+		struct regex_first<regex<match_range_t<T>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_range_t<T>>& rule) noexcept
+			{
+				if constexpr(sizeof(T) == 1)
+					return regex_lookahead{regex_class<regex<match_range_t<T>>>::set(rule), false};
+				else
+					return regex_unknown_lookahead();
+			}
+		};
+
+		template<class T, std::size_t Count, std::size_t Capacity>
+		struct regex_first<regex<match_literals_t<T, Count, Capacity>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_literals_t<T, Count, Capacity>>& rule) noexcept
+			{
+				regex_lookahead result;
+				const auto& offsets = regex_access::offsets(rule);
+				for(std::size_t i = 0; i < Count; ++i)
+					result.bytes.set(regex_byte(regex_access::values(rule)[offsets[i]]));
+				return result;
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_first<regex<match_or_t<Regexs...>>>
+		{
+			template<std::size_t... I>
+			static constexpr regex_lookahead lookahead(const regex<match_or_t<Regexs...>>& rule, std::index_sequence<I...>) noexcept
+			{
+				regex_lookahead result;
+				const auto& lookahead = regex_access::lookahead(rule);
+				((result.bytes |= lookahead[I].bytes, result.nullable = result.nullable || lookahead[I].nullable), ...);
+				return result;
+			}
+			static constexpr regex_lookahead lookahead(const regex<match_or_t<Regexs...>>& rule) noexcept
+			{
+				return lookahead(rule, std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_first<regex<match_and_t<Regexs...>>>
+		{
+			template<std::size_t... I>
+			static constexpr regex_lookahead lookahead(const regex<match_and_t<Regexs...>>& rule, std::index_sequence<I...>) noexcept
+			{
+				regex_lookahead result;
+				result.nullable = true;
+				const auto& matchs = regex_access::matchs(rule);
+				const auto append = [&result](const regex_lookahead& next) {
+					if(result.nullable) {
+						result.bytes |= next.bytes;
+						result.nullable = next.nullable;
+					}
+				};
+				(append(regex_first<Regexs>::lookahead(std::get<I>(matchs))), ...);
+				return result;
+			}
+			static constexpr regex_lookahead lookahead(const regex<match_and_t<Regexs...>>& rule) noexcept
+			{
+				return lookahead(rule, std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class Begin, class End>
+		inline constexpr bool regex_contiguous_v = std::is_pointer_v<Begin>
+			&& std::is_same_v<Begin, std::decay_t<decltype(regex_end<End>::get(std::declval<End>()))>>
+			&& sizeof(*std::declval<Begin>()) == 1;
+
+		template<class Begin, class End>
+		std::size_t regex_run(const regex_byteclass& byteclass, Begin it, const End& end) noexcept
+		{
+			const auto count = byteclass.run(it, regex_end<End>::get(end));
+			regex_end<End>::hit(it + count, end);
+			return count;
+		}
+	}
+
+	template<class Regex>
+	constexpr regex_lookahead lookahead(const regex<Regex>& rule) noexcept
+	{
+		return details::regex_first<regex<Regex>>::lookahead(rule);
+	}
+
 	template<class Match>
 	struct match_zero_plus;
 
 	template<class Match>
 	class regex<match_zero_plus<Match>>
 	{
+		friend struct details::regex_access;
 		Match match;
+		decltype(details::regex_class<Match>::byteclass(std::declval<Match>())) byteclass;
 	public:
 		constexpr regex(const Match& match) noexcept
 		: match(match)
+		, byteclass(details::regex_class<Match>::byteclass(match))
 		{}
 		regex(regex&&) = default;
 		regex(const regex&) = default;
@@ -721,10 +1334,31 @@ namespace utils {
 		using value_type = std::vector<typename Match::value_type>;
 		using result_t = std::optional<value_type>;
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			if constexpr(details::regex_class<Match>::value && details::regex_contiguous_v<Begin, End>) {
+				if(!regex_constant_evaluated()) {
+					it += details::regex_run(byteclass, it, end);
+					return true;
+				}
+			}
+			while(match.scan(it, end));
+			return true;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
 			value_type results;
+			if constexpr(details::regex_class<Match>::value && details::regex_contiguous_v<Begin, End>) {
+				if(!regex_constant_evaluated()) {
+					const Begin stop = it + details::regex_run(byteclass, it, end);
+					results.reserve(stop - it);
+					while(it != stop)
+						results.emplace_back(*match(it, stop));
+					return std::make_optional<value_type>(std::move(results));
+				}
+			}
 			while(auto result = match(it, end)) {
 				results.emplace_back(*std::move(result));
 			}
@@ -784,6 +1418,7 @@ namespace utils {
 	template<class Match>
 	class regex<match_optional<Match>>
 	{
+		friend struct details::regex_access;
 		Match match;
 	public:
 		constexpr regex(const Match& match) noexcept
@@ -797,6 +1432,12 @@ namespace utils {
 		using value_type = typename Match::result_t;
 		using result_t = std::optional<value_type>;
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			match.scan(it, end);
+			return true;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
@@ -839,10 +1480,13 @@ namespace utils {
 	template<class Match>
 	class regex<match_one_plus<Match>>
 	{
+		friend struct details::regex_access;
 		Match match;
+		decltype(details::regex_class<Match>::byteclass(std::declval<Match>())) byteclass;
 	public:
 		constexpr regex(const Match& match) noexcept
 		: match(match)
+		, byteclass(details::regex_class<Match>::byteclass(match))
 		{}
 		regex(regex&&) = default;
 		regex(const regex&) = default;
@@ -852,10 +1496,36 @@ namespace utils {
 		using value_type = std::vector<typename Match::value_type>;
 		using result_t = std::optional<value_type>;
 	public:
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			if constexpr(details::regex_class<Match>::value && details::regex_contiguous_v<Begin, End>) {
+				if(!regex_constant_evaluated()) {
+					const auto count = details::regex_run(byteclass, it, end);
+					it += count;
+					return count != 0;
+				}
+			}
+			if(!match.scan(it, end))
+				return false;
+			while(match.scan(it, end));
+			return true;
+		}
 		template<class Begin, class End>
 		constexpr result_t operator()(Begin& it, End end) const
 		{
 			value_type results;
+			if constexpr(details::regex_class<Match>::value && details::regex_contiguous_v<Begin, End>) {
+				if(!regex_constant_evaluated()) {
+					const Begin stop = it + details::regex_run(byteclass, it, end);
+					if(stop == it)
+						return std::nullopt;
+					results.reserve(stop - it);
+					while(it != stop)
+						results.emplace_back(*match(it, stop));
+					return std::make_optional<value_type>(std::move(results));
+				}
+			}
 			if(auto result = match(it, end))
 			{
 				results.emplace_back(*std::move(result));
@@ -867,7 +1537,7 @@ namespace utils {
 			return std::nullopt;
 		}
 		template<class T, std::size_t Size>
-		constexpr auto operator()(const T(&value)[Size]) const
+		constexpr result_t operator()(const T(&value)[Size]) const
 		{
 			auto beging = &value[0];
 			auto end = beging + Size - 1;
@@ -898,4 +1568,120 @@ namespace utils {
 		return regex<match_one_plus<regex<Match>>>(std::move(match));
 	}
 
+	template<class Match>
+	struct match_named;
+
+	template<class Match>
+	class regex<match_named<Match>>
+	{
+		friend struct details::regex_access;
+		Match match;
+		const char* name;
+	public:
+		constexpr regex(const char* name, const Match& match) noexcept
+		: match(match)
+		, name(name)
+		{}
+		regex(regex&&) = default;
+		regex(const regex&) = default;
+		regex& operator=(const regex&) = default;
+		regex& operator=(regex&&) = default;
+	public:
+		using value_type = typename Match::value_type;
+		using result_t = typename Match::result_t;
+	public:
+		constexpr const char* label() const noexcept
+		{
+			return name;
+		}
+		template<class Begin, class End>
+		constexpr bool scan(Begin& it, End end) const
+		{
+			return match.scan(it, end);
+		}
+		template<class Begin, class End>
+		constexpr result_t operator()(Begin& it, End end) const
+		{
+			return match(it, end);
+		}
+		template<class T, std::size_t Size>
+		constexpr result_t operator()(const T(&value)[Size]) const
+		{
+			return match(value);
+		}
+		constexpr auto operator()(const value_type& value) const
+		{
+			return match(value);
+		}
+		friend constexpr bool operator==(const regex& a, const regex& b) noexcept
+		{
+			return a.match == b.match;
+		}
+	};
+
+	template<class Match>
+	constexpr auto named(const char* name, regex<Match> match) noexcept
+	{
+		return regex<match_named<regex<Match>>>(name, std::move(match));
+	}
+
+	namespace details
+	{
+		template<class Match>
+		struct regex_first<regex<match_zero_plus<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_zero_plus<Match>>& rule) noexcept
+			{
+				auto result = regex_first<Match>::lookahead(regex_access::match(rule));
+				result.nullable = true;
+				return result;
+			}
+		};
+
+		template<class Match>
+		struct regex_first<regex<match_one_plus<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_one_plus<Match>>& rule) noexcept
+			{
+				return regex_first<Match>::lookahead(regex_access::match(rule));
+			}
+		};
+
+		template<class Match>
+		struct regex_first<regex<match_optional<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_optional<Match>>& rule) noexcept
+			{
+				auto result = regex_first<Match>::lookahead(regex_access::match(rule));
+				result.nullable = true;
+				return result;
+			}
+		};
+
+		template<class Regex, class Match>
+		struct regex_class_forward: std::bool_constant<regex_class<Match>::value>
+		{
+			static constexpr auto byteclass(const Regex& rule) noexcept
+			{
+				return regex_class<Match>::byteclass(regex_access::match(rule));
+			}
+			static constexpr regex_byteset set(const Regex& rule) noexcept
+			{
+				return regex_class<Match>::set(regex_access::match(rule));
+			}
+		};
+
+		template<class Match>
+		struct regex_class<regex<match_named<Match>>>: regex_class_forward<regex<match_named<Match>>, Match> {};
+
+		template<class Match>
+		struct regex_first<regex<match_named<Match>>>
+		{
+			static constexpr regex_lookahead lookahead(const regex<match_named<Match>>& rule) noexcept
+			{
+				return regex_first<Match>::lookahead(regex_access::match(rule));
+			}
+		};
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,322 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+#include <utils/buffer.hpp>
+#include <utils/regex/regular.hpp>
+#include <utils/regex/dfa.hpp>
+#include <utils/regex/simd.hpp>
+
+namespace utils {
+
+	struct regex_prefix
+	{
+		static constexpr std::size_t capacity = 32;
+		std::array<std::uint8_t, capacity> bytes{};
+		std::size_t size = 0;
+		// The rule matches exactly these bytes and nothing else.
+		bool complete = false;
+	public:
+		constexpr regex_prefix& push(std::uint8_t byte) noexcept
+		{
+			if(size < capacity)
+				bytes[size++] = byte;
+			else
+				complete = false;
+			return *this;
+		}
+		constexpr regex_prefix& append(const regex_prefix& other) noexcept
+		{
+			const auto count = std::min(other.size, capacity - size);
+			for(std::size_t i = 0; i < count; ++i)
+				bytes[size + i] = other.bytes[i];
+			size += count;
+			complete = complete && other.complete && count == other.size;
+			return *this;
+		}
+		constexpr regex_prefix common(const regex_prefix& other) const noexcept
+		{
+			regex_prefix result;
+			while(result.size < std::min(size, other.size) && bytes[result.size] == other.bytes[result.size]) {
+				result.bytes[result.size] = bytes[result.size];
+				++result.size;
+			}
+			result.complete = complete && other.complete && size == other.size && result.size == size;
+			return result;
+		}
+	};
+
+	namespace details
+	{
+		template<class Regex>
+		struct regex_literal_prefix
+		{
+			static constexpr regex_prefix get(const Regex&) noexcept
+			{
+				return {};
+			}
+		};
+
+		template<class T, std::size_t Size>
+		struct regex_literal_prefix<regex<match_sequence_t<T, Size>>>
+		{
+			static constexpr regex_prefix get(const regex<match_sequence_t<T, Size>>& rule) noexcept
+			{
+				regex_prefix result;
+				if constexpr(sizeof(T) == 1) {
+					result.complete = true;
+					for(const auto& value: regex_access::values(rule))
+						result.push(regex_byte(value));
+				}
+				return result;
+			}
+		};
+
+		template<class T, std::size_t Count, std::size_t Capacity>
+		struct regex_literal_prefix<regex<match_literals_t<T, Count, Capacity>>>
+		{
+			static constexpr regex_prefix get(const regex<match_literals_t<T, Count, Capacity>>& rule) noexcept
+			{
+				const auto& values = regex_access::values(rule);
+				const auto& offsets = regex_access::offsets(rule);
+				regex_prefix result;
+				for(std::size_t i = 0; i < Count; ++i) {
+					regex_prefix literal;
+					literal.complete = true;
+					for(std::size_t at = offsets[i]; at < offsets[i + 1]; ++at)
+						literal.push(regex_byte(values[at]));
+					result = i ? result.common(literal) : literal;
+				}
+				return result;
+			}
+		};
+
+		template<class ...Regexs>
+		struct regex_literal_prefix<regex<match_and_t<Regexs...>>>
+		{
+			template<std::size_t... I>
+			static constexpr regex_prefix get(const regex<match_and_t<Regexs...>>& rule, std::index_sequence<I...>) noexcept
+			{
+				regex_prefix result;
+				result.complete = true;
+				static_cast<void>(((result.append(regex_literal_prefix<Regexs>::get(std::get<I>(regex_access::matchs(rule)))), result.complete) && ...));
+				return result;
+			}
+			static constexpr regex_prefix get(const regex<match_and_t<Regexs...>>& rule) noexcept
+			{
+				return get(rule, std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class Regex, class ...Regexs>
+		struct regex_literal_prefix<regex<match_or_t<Regex, Regexs...>>>
+		{
+			template<std::size_t... I>
+			static constexpr regex_prefix get(const regex<match_or_t<Regex, Regexs...>>& rule, std::index_sequence<I...>) noexcept
+			{
+				const auto& matchs = regex_access::matchs(rule);
+				auto result = regex_literal_prefix<Regex>::get(std::get<0>(matchs));
+				((result = result.common(regex_literal_prefix<Regexs>::get(std::get<I + 1>(matchs)))), ...);
+				return result;
+			}
+			static constexpr regex_prefix get(const regex<match_or_t<Regex, Regexs...>>& rule) noexcept
+			{
+				return get(rule, std::index_sequence_for<Regexs...>());
+			}
+		};
+
+		template<class Match>
+		struct regex_literal_prefix<regex<match_one_plus<Match>>>
+		{
+			static constexpr regex_prefix get(const regex<match_one_plus<Match>>& rule) noexcept
+			{
+				auto result = regex_literal_prefix<Match>::get(regex_access::match(rule));
+				result.complete = false;
+				return result;
+			}
+		};
+
+		template<class Match>
+		struct regex_literal_prefix<regex<match_named<Match>>>
+		{
+			static constexpr regex_prefix get(const regex<match_named<Match>>& rule) noexcept
+			{
+				return regex_literal_prefix<Match>::get(regex_access::match(rule));
+			}
+		};
+	}
+
+	template<class Regex>
+	constexpr regex_prefix literal_prefix(const regex<Regex>& rule) noexcept
+	{
+		return details::regex_literal_prefix<regex<Regex>>::get(rule);
+	}
+
+	enum class regex_strategy: std::uint8_t { every, byteclass, byte, literal };
+
+	// Candidates come from the mandatory literal prefix when the rule has one
+	// (memchr for one byte; SSE2 first/last byte filtering, or Horspool, for
+	// longer ones), otherwise from the set of bytes a match can start with.
+	// The rule itself only runs at candidates. A dense first-byte set (such as
+	// the letters starting an identifier) hits most of the text, and skipping
+	// to it costs more than trying the rule at every position.
+	template<class Regex>
+	class regex_searcher
+	{
+		using strategy = regex_strategy;
+		using input_t = regex_input_t<regex<Regex>>;
+		static_assert(sizeof(input_t) == 1, "searching needs a byte sized input");
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+		static constexpr std::size_t sparse = 16;
+
+		regex<Regex> rule;
+		regex_prefix prefix;
+		regex_byteclass skip;
+		std::array<std::uint8_t, 256> shifts{};
+		strategy mode = strategy::every;
+		bool nullable = false;
+	public:
+		constexpr regex_searcher(const regex<Regex>& rule) noexcept
+		: rule(rule)
+		, prefix(literal_prefix(rule))
+		{
+			const auto first = lookahead(rule);
+			nullable = first.nullable;
+			if(prefix.size > 1) {
+				mode = strategy::literal;
+				for(auto& shift: shifts)
+					shift = static_cast<std::uint8_t>(prefix.size);
+				for(std::size_t i = 0; i + 1 < prefix.size; ++i)
+					shifts[prefix.bytes[i]] = static_cast<std::uint8_t>(prefix.size - 1 - i);
+			} else if(prefix.size) {
+				mode = strategy::byte;
+			} else if(!first.nullable && first.bytes.count() <= sparse) {
+				mode = strategy::byteclass;
+				skip = regex_byteclass(regex_byteset(first.bytes).flip());
+			}
+		}
+		regex_searcher(const regex_searcher&) = default;
+		regex_searcher& operator=(const regex_searcher&) = default;
+	private:
+		const std::uint8_t* horspool(const std::uint8_t* at, const std::uint8_t* end) const noexcept
+		{
+			const auto last = prefix.bytes[prefix.size - 1];
+			for(; static_cast<std::size_t>(end - at) >= prefix.size; at += shifts[at[prefix.size - 1]])
+				if(at[prefix.size - 1] == last && !std::memcmp(at, prefix.bytes.data(), prefix.size - 1))
+					return at;
+			return end;
+		}
+		const std::uint8_t* literal(const std::uint8_t* at, const std::uint8_t* end) const noexcept
+		{
+#if defined(UTILS_REGEX_SSE2)
+			const auto distance = prefix.size - 1;
+			const auto first = _mm_set1_epi8(static_cast<char>(prefix.bytes[0]));
+			const auto last = _mm_set1_epi8(static_cast<char>(prefix.bytes[distance]));
+			for(; static_cast<std::size_t>(end - at) >= distance + 16; at += 16) {
+				const auto heads = _mm_cmpeq_epi8(first, _mm_loadu_si128(reinterpret_cast<const __m128i*>(at)));
+				const auto tails = _mm_cmpeq_epi8(last, _mm_loadu_si128(reinterpret_cast<const __m128i*>(at + distance)));
+				for(auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(heads, tails))); mask; mask &= mask - 1) {
+					const auto candidate = at + __builtin_ctz(mask);
+					if(!std::memcmp(candidate + 1, prefix.bytes.data() + 1, distance - 1))
+						return candidate;
+				}
+			}
+#endif
+			return horspool(at, end);
+		}
+		const std::uint8_t* next(const std::uint8_t* at, const std::uint8_t* end) const noexcept
+		{
+			switch(mode) {
+				case strategy::byte:
+					if(const auto found = std::memchr(at, prefix.bytes[0], end - at))
+						return static_cast<const std::uint8_t*>(found);
+					return end;
+				case strategy::literal:
+					return literal(at, end);
+				case strategy::byteclass:
+					for(const auto stop = at + std::min<std::ptrdiff_t>(end - at, 16); at != stop; ++at)
+						if(!skip.test(*at))
+							return at;
+					return at + skip.run(at, end);
+				default:
+					return at;
+			}
+		}
+		std::size_t match(const std::uint8_t* at, const std::uint8_t* end) const
+		{
+			if(prefix.complete && mode != strategy::every)
+				return prefix.size;
+			const auto begin = reinterpret_cast<const input_t*>(at);
+			auto it = begin;
+			if(rule.scan(it, reinterpret_cast<const input_t*>(end)))
+				return it - begin;
+			return npos;
+		}
+		template<class T, class Visitor>
+		void each(buffer::view<T> text, Visitor&& visitor) const
+		{
+			static_assert(sizeof(T) == 1, "searching needs a byte sized input");
+			const auto begin = reinterpret_cast<const std::uint8_t*>(text.data());
+			const auto end = begin + text.size();
+			for(auto at = begin;; ++at) {
+				at = next(at, end);
+				if(at == end && !nullable)
+					return;
+				if(const auto size = match(at, end); size != npos) {
+					if(!visitor(text.slice(at - begin, size)))
+						return;
+					at += size ? size - 1 : 0;
+				}
+				if(at == end)
+					return;
+			}
+		}
+	public:
+		constexpr regex_strategy method() const noexcept
+		{
+			return mode;
+		}
+		template<class T>
+		std::optional<buffer::view<T>> find(buffer::view<T> text) const
+		{
+			std::optional<buffer::view<T>> result;
+			each(text, [&result](buffer::view<T> found) {
+				result = found;
+				return false;
+			});
+			return result;
+		}
+		template<class T>
+		std::vector<buffer::view<T>> find_all(buffer::view<T> text) const
+		{
+			std::vector<buffer::view<T>> results;
+			each(text, [&results](buffer::view<T> found) {
+				results.push_back(found);
+				return true;
+			});
+			return results;
+		}
+	};
+
+	template<class Regex>
+	constexpr auto searcher(const regex<Regex>& rule) noexcept
+	{
+		return regex_searcher<Regex>(rule);
+	}
+
+	template<class Regex, class T>
+	std::optional<buffer::view<T>> find(const regex<Regex>& rule, buffer::view<T> text)
+	{
+		return regex_searcher<Regex>(rule).find(text);
+	}
+
+	template<class Regex, class T>
+	std::vector<buffer::view<T>> find_all(const regex<Regex>& rule, buffer::view<T> text)
+	{
+		return regex_searcher<Regex>(rule).find_all(text);
+	}
+
+}
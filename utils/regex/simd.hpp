@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <utils/regex/bitset.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	define UTILS_REGEX_SSE2 1
+#	include <emmintrin.h>
+#	if defined(__GNUC__) || defined(__clang__)
+#		define UTILS_REGEX_AVX2 1
+#		include <immintrin.h>
+#	endif
+#endif
+
+namespace utils {
+
+	constexpr bool regex_constant_evaluated() noexcept
+	{
+		return __builtin_is_constant_evaluated();
+	}
+
+	class regex_byteclass
+	{
+	public:
+		static constexpr std::size_t max_ranges = 8;
+		enum class kernel { scalar, sse2, avx2 };
+	private:
+		regex_byteset bits;
+		std::array<std::uint8_t, max_ranges> lows{};
+		std::array<std::uint8_t, max_ranges> widths{};
+		std::size_t ranges = 0;
+	public:
+		constexpr regex_byteclass() noexcept = default;
+		constexpr regex_byteclass(const regex_byteset& bits) noexcept
+		: bits(bits)
+		{
+			for(std::size_t byte = 0; byte < bits.size(); ) {
+				if(!bits.test(byte)) {
+					++byte;
+					continue;
+				}
+				const auto low = byte;
+				while(byte < bits.size() && bits.test(byte))
+					++byte;
+				if(ranges < max_ranges) {
+					lows[ranges] = static_cast<std::uint8_t>(low);
+					widths[ranges] = static_cast<std::uint8_t>(byte - 1 - low);
+				}
+				++ranges;
+			}
+		}
+		regex_byteclass(const regex_byteclass&) = default;
+		regex_byteclass& operator=(const regex_byteclass&) = default;
+	public:
+		constexpr bool test(std::uint8_t byte) const noexcept
+		{
+			return bits.test(byte);
+		}
+		constexpr const regex_byteset& set() const noexcept
+		{
+			return bits;
+		}
+		constexpr bool vectorizable() const noexcept
+		{
+			return ranges <= max_ranges;
+		}
+	public:
+		std::size_t scalar(const std::uint8_t* begin, const std::uint8_t* end) const noexcept
+		{
+			auto it = begin;
+			for(; end - it >= 4; it += 4) {
+				if(!bits.test(it[0])) return it - begin;
+				if(!bits.test(it[1])) return it - begin + 1;
+				if(!bits.test(it[2])) return it - begin + 2;
+				if(!bits.test(it[3])) return it - begin + 3;
+			}
+			while(it != end && bits.test(*it))
+				++it;
+			return it - begin;
+		}
+#if defined(UTILS_REGEX_SSE2)
+		std::size_t sse2(const std::uint8_t* begin, const std::uint8_t* end) const noexcept
+		{
+			if(!vectorizable())
+				return scalar(begin, end);
+			auto it = begin;
+			for(; end - it >= 16; it += 16) {
+				const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+				auto members = _mm_setzero_si128();
+				for(std::size_t i = 0; i < ranges; ++i) {
+					const auto shifted = _mm_sub_epi8(block, _mm_set1_epi8(static_cast<char>(lows[i])));
+					const auto clamped = _mm_min_epu8(shifted, _mm_set1_epi8(static_cast<char>(widths[i])));
+					members = _mm_or_si128(members, _mm_cmpeq_epi8(clamped, shifted));
+				}
+				const auto mask = static_cast<unsigned>(_mm_movemask_epi8(members));
+				if(mask != 0xFFFFu)
+					return it - begin + __builtin_ctz(~mask);
+			}
+			return it - begin + scalar(it, end);
+		}
+#endif
+#if defined(UTILS_REGEX_AVX2)
+		__attribute__((target("avx2")))
+		std::size_t avx2(const std::uint8_t* begin, const std::uint8_t* end) const noexcept
+		{
+			if(!vectorizable())
+				return scalar(begin, end);
+			auto it = begin;
+			for(; end - it >= 32; it += 32) {
+				const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+				auto members = _mm256_setzero_si256();
+				for(std::size_t i = 0; i < ranges; ++i) {
+					const auto shifted = _mm256_sub_epi8(block, _mm256_set1_epi8(static_cast<char>(lows[i])));
+					const auto clamped = _mm256_min_epu8(shifted, _mm256_set1_epi8(static_cast<char>(widths[i])));
+					members = _mm256_or_si256(members, _mm256_cmpeq_epi8(clamped, shifted));
+				}
+				const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(members));
+				if(mask != 0xFFFFFFFFu)
+					return it - begin + __builtin_ctz(~mask);
+			}
+			return it - begin + sse2(it, end);
+		}
+#endif
+		static kernel best() noexcept
+		{
+#if defined(UTILS_REGEX_AVX2)
+			static const bool avx2 = __builtin_cpu_supports("avx2");
+			if(avx2)
+				return kernel::avx2;
+#endif
+#if defined(UTILS_REGEX_SSE2)
+			return kernel::sse2;
+#else
+			return kernel::scalar;
+#endif
+		}
+		std::size_t run(kernel type, const std::uint8_t* begin, const std::uint8_t* end) const noexcept
+		{
+			switch(type) {
+#if defined(UTILS_REGEX_AVX2)
+				case kernel::avx2: return avx2(begin, end);
+#endif
+#if defined(UTILS_REGEX_SSE2)
+				case kernel::sse2: return sse2(begin, end);
+#endif
+				default: return scalar(begin, end);
+			}
+		}
+		std::size_t run(const std::uint8_t* begin, const std::uint8_t* end) const noexcept
+		{
+			static const auto type = best();
+			return run(type, begin, end);
+		}
+		template<class T>
+		std::size_t run(const T* begin, const T* end) const noexcept
+		{
+			static_assert(sizeof(T) == 1);
+			return run(reinterpret_cast<const std::uint8_t*>(begin), reinterpret_cast<const std::uint8_t*>(end));
+		}
+	};
+
+}
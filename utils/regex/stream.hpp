@@ -0,0 +1,122 @@
+#pragma once
+#include <vector>
+#include <utils/regex/regular.hpp>
+#include <utils/regex/dfa.hpp>
+
+namespace utils {
+
+	namespace details
+	{
+		template<class Iterator, class = void>
+		struct regex_segmented: std::false_type {};
+
+		template<class Iterator>
+		struct regex_segmented<Iterator, std::void_t<
+			decltype(std::declval<const Iterator&>().segment().data()),
+			decltype(std::declval<Iterator&>().advance(std::size_t()))
+		>>: std::true_type {};
+
+		template<class Regex, class = void>
+		struct regex_resumable: std::false_type {};
+
+		template<class Regex>
+		struct regex_resumable<Regex, std::void_t<decltype(std::declval<const Regex&>().resumable())>>: std::true_type {};
+
+		// The match ran into the end of its segment: a resumable rule is fed
+		// the segments after it one by one.
+		template<class Regex, class Iterator>
+		bool regex_resume(const regex<Regex>& rule, Iterator& it, const Iterator& end)
+		{
+			using T = regex_input_t<regex<Regex>>;
+			const auto feed = [&rule](auto& match, const auto& segment) {
+				const T* stop = reinterpret_cast<const T*>(segment.data());
+				return rule.resume(match, stop, stop + segment.size());
+			};
+			auto match = rule.resumable();
+			if(it != end && !feed(match, it.segment())) {
+				Iterator next = it;
+				do
+					next.advance(next.segment().size());
+				while(next != end && !feed(match, next.segment()));
+			}
+			if(const auto length = match.length()) {
+				it.advance(*length);
+				return true;
+			}
+			return false;
+		}
+
+		// Other rules get the segments after it copied behind it until a scan
+		// stops short of the copy's end.
+		// Each re-scan starts from the front, so the window at least doubles
+		// between scans to keep a long match linear in its length.
+		template<class Regex, class Iterator>
+		bool regex_stitch(const regex<Regex>& rule, Iterator& it, const Iterator& end)
+		{
+			using T = regex_input_t<regex<Regex>>;
+			auto segment = it.segment();
+			const T* const begin = reinterpret_cast<const T*>(segment.data());
+			std::vector<T> stitch(begin, begin + segment.size());
+			const T* stop = stitch.data();
+			bool matched = false;
+			for(Iterator next = it;;) {
+				bool last = false;
+				const std::size_t window = stitch.size() * 2;
+				do {
+					next.advance(segment.size());
+					if(next == end) {
+						last = true;
+						break;
+					}
+					segment = next.segment();
+					const T* const more = reinterpret_cast<const T*>(segment.data());
+					stitch.insert(stitch.end(), more, more + segment.size());
+				} while(stitch.size() < window);
+				stop = stitch.data();
+				if(last) {
+					matched = rule.scan(stop, stitch.data() + stitch.size());
+					break;
+				}
+				bool reached = false;
+				matched = rule.scan(stop, regex_bound<T>(stitch.data() + stitch.size(), reached));
+				if(!reached)
+					break;
+			}
+			if(matched)
+				it.advance(stop - stitch.data());
+			return matched;
+		}
+	}
+
+	template<class Iterator>
+	inline constexpr bool regex_segmented_v = details::regex_segmented<Iterator>::value;
+
+	template<class Rule>
+	inline constexpr bool regex_resumable_v = details::regex_resumable<Rule>::value;
+
+	template<class Regex, class Iterator>
+	bool scan(const regex<Regex>& rule, Iterator& it, const Iterator& end)
+	{
+		if constexpr(regex_segmented_v<Iterator>) {
+			using T = regex_input_t<regex<Regex>>;
+			static_assert(sizeof(T) == 1, "segmented scanning needs a byte sized input");
+			const auto segment = it.segment();
+			const T* const begin = reinterpret_cast<const T*>(segment.data());
+			const T* stop = begin;
+			bool reached = false;
+			const bool matched = rule.scan(stop, regex_bound<T>(begin + segment.size(), reached));
+			if(!reached) {
+				if(matched)
+					it.advance(stop - begin);
+				return matched;
+			}
+			if constexpr(regex_resumable_v<regex<Regex>>)
+				return details::regex_resume(rule, it, end);
+			else
+				return details::regex_stitch(rule, it, end);
+		} else {
+			return rule.scan(it, end);
+		}
+	}
+
+}
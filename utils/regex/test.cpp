@@ -2,9 +2,59 @@
 
 #include <utils/regex/regular.hpp>
 #include <utils/regex/tokenizer.hpp>
+#include <utils/regex/dfa.hpp>
+#include <utils/regex/simd.hpp>
+#include <utils/regex/stream.hpp>
+#include <utils/regex/profile.hpp>
+#include <utils/regex/search.hpp>
+#include <utils/regex/memo.hpp>
+#include <utils/stream/items.hpp>
+#include <utils/stream/chunked.hpp>
 #include <utils/tag.hpp>
 #include <utils/demangler.hpp>
 #include <tuple>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+namespace {
+	std::size_t allocations = 0;
+}
+
+// Kept out of line: once inlined, GCC pairs free() with the caller's new
+// expression and reports a mismatched deallocation.
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+	++allocations;
+	if(void* pointer = std::malloc(size))
+		return pointer;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	operator delete(pointer);
+}
 
 namespace utils
 {
@@ -94,6 +144,556 @@ TEST_CASE("utils regex results", "[utils], [regex]")
 	}
 }
 
+namespace {
+
+	template<class Reference, class Compiled>
+	void require_same_matches(const Reference& reference, const Compiled& compiled, std::string_view alphabet, std::size_t length)
+	{
+		std::string input(length, alphabet.front());
+		std::vector<std::size_t> digits(length, 0);
+		for(;;) {
+			for(std::size_t size = 0; size <= length; ++size) {
+				const char* rit = input.data();
+				const char* cit = input.data();
+				const bool rmatched = static_cast<bool>(reference(rit, input.data() + size));
+				const bool cmatched = static_cast<bool>(compiled(cit, input.data() + size));
+				INFO("input: \"" << input.substr(0, size) << "\"");
+				REQUIRE(rmatched == cmatched);
+				if(rmatched)
+					REQUIRE(rit == cit);
+			}
+			std::size_t i = 0;
+			for(; i < length && ++digits[i] == alphabet.size(); ++i) {
+				digits[i] = 0;
+				input[i] = alphabet[0];
+			}
+			if(i == length)
+				break;
+			input[i] = alphabet[digits[i]];
+		}
+	}
+}
+
+TEST_CASE("utils regex compiled to dfa", "[utils], [regex], [dfa]")
+{
+	const auto& match = utils::match;
+	constexpr auto symbol = match('a', 'z') | match('A', 'Z') | match("_");
+	constexpr auto digit = match('0', '9');
+	constexpr auto identifier = symbol & *(symbol | digit);
+	constexpr auto number = +digit & !(match(".") & *digit);
+	constexpr auto space = +match[" \t\r\n"];
+	{
+		constexpr auto dfa = utils::compile(identifier);
+		static_assert(dfa.size() == 3);
+		static_assert(std::tuple_size_v<decltype(dfa)::table_t> == 16u * 15u);
+		REQUIRE(!dfa("0123"));
+		REQUIRE(*dfa("some_value_0123") == "some_value_0123");
+		require_same_matches(identifier, dfa, "aZ_9. ", 5);
+	}
+	{
+		constexpr auto dfa = utils::compile(number);
+		REQUIRE(dfa("3.1415"));
+		REQUIRE(dfa("42"));
+		REQUIRE(!dfa(".5"));
+		require_same_matches(number, dfa, "09.a", 6);
+	}
+	{
+		constexpr auto dfa = utils::compile(space | identifier | number);
+		require_same_matches(space | identifier | number, dfa, " a9.\n", 5);
+	}
+	{
+		constexpr auto keywords = match("and") | match("break") | match("goto") | match("local") | match("return") | match("while");
+		constexpr auto dfa = utils::compile(keywords);
+		REQUIRE(dfa("local"));
+		REQUIRE(!dfa("lo"));
+		require_same_matches(keywords, dfa, "alnocdg", 5);
+	}
+}
+
+TEST_CASE("utils regex byte class kernels", "[utils], [regex], [simd]")
+{
+	using kernel = utils::regex_byteclass::kernel;
+	const auto& match = utils::match;
+	constexpr auto word = match('a', 'z') | match('0', '9') | match["_"];
+	constexpr auto wide = match["acegikmoqsuwy13579"];
+	const utils::regex_byteclass classes[] = {
+		utils::details::regex_class<std::remove_const_t<decltype(word)>>::byteclass(word),
+		utils::details::regex_class<std::remove_const_t<decltype(wide)>>::byteclass(wide),
+	};
+	REQUIRE(classes[0].vectorizable());
+	REQUIRE(!classes[1].vectorizable());
+
+	std::string input;
+	for(std::size_t i = 0; i < 300; ++i)
+		input += "abcdefghijklmnopqrstuvwxyz_0123456789"[(i * 7) % 37];
+	std::vector<kernel> kernels = {kernel::scalar, utils::regex_byteclass::best()};
+#if defined(UTILS_REGEX_SSE2)
+	kernels.push_back(kernel::sse2);
+#endif
+	for(const auto& byteclass: classes) {
+		for(std::size_t stop = 0; stop < input.size(); stop += 13) {
+			std::string data = input;
+			data[stop] = '-';
+			const auto begin = reinterpret_cast<const std::uint8_t*>(data.data());
+			for(std::size_t offset = 0; offset < 40 && offset <= stop; ++offset) {
+				std::size_t expected = 0;
+				while(offset + expected < data.size() && byteclass.test(begin[offset + expected]))
+					++expected;
+				for(auto type: kernels)
+					REQUIRE(byteclass.run(type, begin + offset, begin + data.size()) == expected);
+			}
+		}
+	}
+	{
+		const char text[] = "some_identifier_0123 tail";
+		const char* it = text;
+		const auto result = (*word)(it, text + sizeof(text) - 1);
+		REQUIRE(result);
+		REQUIRE(result->size() == 20);
+		REQUIRE(*it == ' ');
+		REQUIRE((*word)(*result) == "some_identifier_0123");
+		REQUIRE(!(+word)(" tail"));
+	}
+	{
+		constexpr auto mixed = *(match("ab") | match('0', '9'));
+		const char text[] = "ab12ab3-";
+		const char* it = text;
+		const auto result = mixed(it, text + sizeof(text) - 1);
+		REQUIRE(result);
+		REQUIRE(result->size() == 5);
+		REQUIRE(*it == '-');
+	}
+}
+
+TEST_CASE("utils regex scan without allocations", "[utils], [regex], [scan]")
+{
+	const auto& match = utils::match;
+	constexpr auto symbol = match('a', 'z') | match('A', 'Z') | match("_");
+	constexpr auto digit = match('0', '9');
+	constexpr auto identifier = symbol & *(symbol | digit);
+	constexpr auto number = +digit & !(match(".") & *digit);
+	constexpr auto pairs = +match("ab") & *match["cd"];
+	constexpr auto dfa = utils::compile(identifier);
+	const std::string text = "some_identifier_0123 3.1415 ababcdc!";
+
+	const auto before = allocations;
+	const char* it = text.data();
+	const char* end = text.data() + text.size();
+	auto sit = text.begin();
+	bool matched = true;
+	std::size_t lengths[5] = {};
+
+	const char* start = it;
+	matched = matched && identifier.scan(it, end);
+	lengths[0] = it - start;
+	matched = matched && match(" ").scan(it, end);
+	start = it;
+	matched = matched && number.scan(it, end);
+	lengths[1] = it - start;
+	matched = matched && match(" ").scan(it, end);
+	start = it;
+	matched = matched && pairs.scan(it, end);
+	lengths[2] = it - start;
+	matched = matched && !identifier.scan(it, end);
+	matched = matched && dfa.scan(sit, text.end());
+	lengths[3] = sit - text.begin();
+	matched = matched && identifier.scan(sit = text.begin(), text.end());
+	lengths[4] = sit - text.begin();
+	const auto after = allocations;
+
+	REQUIRE(matched);
+	REQUIRE(after == before);
+	REQUIRE(lengths[0] == 20);
+	REQUIRE(lengths[1] == 6);
+	REQUIRE(lengths[2] == 7);
+	REQUIRE(lengths[3] == 20);
+	REQUIRE(lengths[4] == 20);
+	REQUIRE(*it == '!');
+}
+
+TEST_CASE("utils regex restores input on failure", "[utils], [regex], [backtracking]")
+{
+	const auto& match = utils::match;
+	{
+		constexpr auto regex = (match("ab") & match("c")) | match("abd");
+		REQUIRE(regex("abc"));
+		REQUIRE(regex("abd"));
+		const std::string text = "abd";
+		auto it = text.begin();
+		REQUIRE(regex.scan(it, text.end()));
+		REQUIRE(it == text.end());
+	}
+	{
+		constexpr auto regex = match("a") & match("b");
+		const char text[] = "ac";
+		const char* it = text;
+		REQUIRE(!regex(it, text + 2));
+		REQUIRE(it == text);
+		REQUIRE(!regex.scan(it, text + 2));
+		REQUIRE(it == text);
+	}
+	{
+		constexpr auto regex = match("x") & !(match("a") & match("b")) & match("ac");
+		REQUIRE(regex("xac"));
+		REQUIRE(regex("xabac"));
+		REQUIRE(!regex("xab"));
+	}
+	{
+		constexpr auto regex = *(match("a") & match("b")) & match("ac");
+		REQUIRE(regex("ababac"));
+		REQUIRE(regex("ac"));
+	}
+}
+
+TEST_CASE("utils regex first byte lookahead", "[utils], [regex], [backtracking]")
+{
+	const auto& match = utils::match;
+	constexpr auto number = +match('0', '9') & !(match(".") & *match('0', '9'));
+	constexpr auto name = (match('a', 'z') | match("_")) & *match('a', 'z');
+	constexpr auto spaces = *match[" \t"];
+	constexpr auto first = utils::details::regex_first<std::remove_const_t<decltype(name)>>::lookahead(name);
+	static_assert(!first.nullable);
+	static_assert(first.bytes.test('a') && first.bytes.test('z') && first.bytes.test('_'));
+	static_assert(!first.bytes.test('0') && !first.bytes.test('A'));
+	static_assert(utils::details::regex_first<std::remove_const_t<decltype(spaces)>>::lookahead(spaces).nullable);
+	constexpr auto optional = !match("-") & number;
+	constexpr auto signed_number = utils::details::regex_first<std::remove_const_t<decltype(optional)>>::lookahead(optional);
+	static_assert(!signed_number.nullable && signed_number.bytes.test('-') && signed_number.bytes.test('7'));
+	static_assert(signed_number.bytes.count() == 11);
+
+	constexpr auto token = number | name | (spaces & match(";"));
+	const std::string text = "12.5 name \t;";
+	auto it = text.begin();
+	REQUIRE(token.scan(it, text.end()));
+	REQUIRE(it - text.begin() == 4);
+	REQUIRE(!token.scan(it, text.end()));
+	REQUIRE(it - text.begin() == 4);
+	REQUIRE(token("name"));
+	REQUIRE(token(" \t;"));
+}
+
+TEST_CASE("utils regex merges adjacent alternatives", "[utils], [regex], [backtracking]")
+{
+	const auto& match = utils::match;
+	constexpr auto symbol = match(".") | match("...") | match("..") | match("::") | match(":") | match("==") | match("=")
+		| match("~=") | match("<=") | match("<") | match(">");
+	const auto length = [](const auto& rule, std::string_view text) -> std::ptrdiff_t {
+		auto it = text.begin();
+		return rule.scan(it, text.end()) ? it - text.begin() : -1;
+	};
+	const auto index = [](const auto& rule, std::string_view text) -> std::ptrdiff_t {
+		auto it = text.begin();
+		if(const auto result = rule(it, text.end()))
+			return result->index();
+		return -1;
+	};
+	REQUIRE(length(symbol, "...") == 1);
+	REQUIRE(index(symbol, "...") == 0);
+	REQUIRE(length(symbol, "::") == 2);
+	REQUIRE(index(symbol, "::") == 3);
+	REQUIRE(index(symbol, ":x") == 4);
+	REQUIRE(index(symbol, "~=") == 7);
+	REQUIRE(length(symbol, "~") == -1);
+	REQUIRE(index(symbol, "<=") == 8);
+	REQUIRE(index(symbol, "<") == 9);
+	REQUIRE(index(symbol, ">") == 10);
+	REQUIRE(index(symbol, "!") == -1);
+
+	constexpr auto longest = match("...") | match("..") | match(".") | match("x");
+	REQUIRE(length(longest, "....") == 3);
+	REQUIRE(index(longest, "..x") == 1);
+	REQUIRE(index(longest, ".x") == 2);
+	REQUIRE(index(longest, "x") == 3);
+
+	constexpr auto mixed = match('a', 'z') | match("_") | match('A', 'Z') | match("0x") | match("0") | +match('0', '9') | match("end");
+	REQUIRE(index(mixed, "q") == 0);
+	REQUIRE(index(mixed, "_") == 1);
+	REQUIRE(index(mixed, "Q") == 2);
+	REQUIRE(index(mixed, "0x1") == 3);
+	REQUIRE(index(mixed, "07") == 4);
+	REQUIRE(length(mixed, "123") == 3);
+	REQUIRE(index(mixed, "123") == 5);
+	REQUIRE(index(mixed, "end") == 0);
+	REQUIRE(length(mixed, "end") == 1);
+
+	constexpr auto keywords = match("do") | match("else") | match("elseif") | match("end") | match("for") | match("function");
+	constexpr auto word = keywords & !match["_"];
+	REQUIRE(length(keywords, "elseif") == 4);
+	REQUIRE(length(keywords, "functio") == -1);
+	REQUIRE(length(keywords, "for") == 3);
+	REQUIRE(index(keywords, "endx") == 3);
+	REQUIRE(length(word, "do_") == 3);
+
+	bool reached = false;
+	const std::string_view partial = "fo";
+	const char* it = partial.data();
+	REQUIRE(!keywords.scan(it, utils::regex_bound<char>(partial.data() + partial.size(), reached)));
+	REQUIRE(reached);
+	REQUIRE(it == partial.data());
+	reached = false;
+	const std::string_view decided = "dox";
+	it = decided.data();
+	REQUIRE(keywords.scan(it, utils::regex_bound<char>(decided.data() + decided.size(), reached)));
+	REQUIRE(it - decided.data() == 2);
+	REQUIRE(!reached);
+}
+
+TEST_CASE("utils regex literal sets", "[utils], [regex]")
+{
+	const auto& match = utils::match;
+	constexpr auto symbol = utils::literals(".", "..", "...", "=", "==", "~=", "<", "<=", "<<", "//", "/");
+	static_assert(symbol.size() == 11);
+	const auto longest = [&symbol](std::string_view text) -> std::pair<std::ptrdiff_t, std::ptrdiff_t> {
+		auto it = text.begin();
+		if(const auto result = symbol(it, text.end()))
+			return {*result, it - text.begin()};
+		return {-1, it - text.begin()};
+	};
+	REQUIRE(longest("....") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(2, 3));
+	REQUIRE(longest("..x") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(1, 2));
+	REQUIRE(longest(".") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(0, 1));
+	REQUIRE(longest("<<=") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(8, 2));
+	REQUIRE(longest("~") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(-1, 0));
+	REQUIRE(longest("") == std::make_pair<std::ptrdiff_t, std::ptrdiff_t>(-1, 0));
+	REQUIRE(symbol("//"));
+	REQUIRE(!symbol("///"));
+	REQUIRE(symbol(*symbol("<=")) == "<=");
+
+	constexpr auto first = utils::lookahead(symbol);
+	static_assert(!first.nullable && first.bytes.count() == 5);
+	static_assert(first.bytes.test('.') && first.bytes.test('~') && !first.bytes.test('>'));
+
+	constexpr auto token = (match('a', 'z') & *match('a', 'z')) | symbol | match[" "];
+	const auto result = token("<=");
+	REQUIRE(result);
+	REQUIRE(result->index() == 1);
+	REQUIRE(token(*result, symbol) == "<=");
+	std::string_view text = "a<=b .. c";
+	std::size_t count = 0;
+	for(auto it = text.begin(); it != text.end() && token.scan(it, text.end());)
+		++count;
+	REQUIRE(count == 7);
+
+	constexpr auto dfa = utils::compile(symbol);
+	require_same_matches(symbol, dfa, ".=<~/", 4);
+}
+
+namespace {
+
+	template<class Rule>
+	void require_same_search(const Rule& rule, std::string_view text)
+	{
+		std::vector<std::pair<std::size_t, std::size_t>> expected;
+		for(std::size_t at = 0; at <= text.size();) {
+			const char* it = text.data() + at;
+			if(rule.scan(it, text.data() + text.size())) {
+				const std::size_t size = it - text.data() - at;
+				expected.emplace_back(at, size);
+				at += size ? size : 1;
+			} else {
+				++at;
+			}
+		}
+		const utils::buffer::view<const char> view(text.data(), text.size());
+		const auto found = utils::find_all(rule, view);
+		INFO("text: \"" << text << "\"");
+		REQUIRE(found.size() == expected.size());
+		for(std::size_t i = 0; i < found.size(); ++i) {
+			REQUIRE(static_cast<std::size_t>(found[i].data() - text.data()) == expected[i].first);
+			REQUIRE(found[i].size() == expected[i].second);
+		}
+		const auto first = utils::find(rule, view);
+		REQUIRE(static_cast<bool>(first) == !expected.empty());
+		if(first)
+			REQUIRE(static_cast<std::size_t>(first->data() - text.data()) == expected.front().first);
+	}
+}
+
+TEST_CASE("utils regex search", "[utils], [regex], [search]")
+{
+	using strategy = utils::regex_strategy;
+	const auto& match = utils::match;
+	constexpr auto name = (match('a', 'z') | match("_")) & *(match('a', 'z') | match("_") | match('0', '9'));
+	constexpr auto comment = match("--[[");
+	constexpr auto line = match("--") & *match('\x0e', '\x7f');
+	constexpr auto brackets = match("--[") & (match("[") | match("=")) | match("--[=") & +match("=");
+	constexpr auto call = name & match("(");
+	constexpr auto digits = +match('0', '9');
+	constexpr auto keywords = utils::literals("function", "local");
+	constexpr auto length = match("#") & name;
+	constexpr auto greedy = *match("a");
+	constexpr auto long_literal = match("0123456789012345678901234567890123456789");
+
+	constexpr auto prefix = utils::literal_prefix(match("--") & match("[[") & name & match("]]"));
+	static_assert(prefix.size == 4 && !prefix.complete && prefix.bytes[2] == '[');
+	static_assert(utils::literal_prefix(comment).complete);
+	static_assert(utils::literal_prefix(brackets).size == 3);
+	static_assert(utils::literal_prefix(long_literal).size == utils::regex_prefix::capacity && !utils::literal_prefix(long_literal).complete);
+	static_assert(utils::literal_prefix(call).size == 0);
+	static_assert(utils::searcher(comment).method() == strategy::literal);
+	static_assert(utils::searcher(line).method() == strategy::literal);
+	static_assert(utils::searcher(length).method() == strategy::byte);
+	static_assert(utils::searcher(call).method() == strategy::every);
+	static_assert(utils::searcher(digits).method() == strategy::byteclass);
+	static_assert(utils::searcher(greedy).method() == strategy::every);
+
+	const std::string_view texts[] = {
+		"",
+		"--[[ block ]] local x = f(1) -- tail\nprint(x)--[==[ long ]==]",
+		"------[[--[=[",
+		"aaa b aa",
+		"function local functional 42 localize",
+		"x 01234567890123456789012345678901234567890123456789 0123456789012345678901234567890123456789",
+		"#a ## #_x1 x --[[ --[ --[[ --[[ --[=== local ----[[ #b function --[[ 0123456789012345678901234567890123456789",
+	};
+	for(const auto& text: texts) {
+		require_same_search(comment, text);
+		require_same_search(line, text);
+		require_same_search(brackets, text);
+		require_same_search(call, text);
+		require_same_search(digits, text);
+		require_same_search(keywords, text);
+		require_same_search(length, text);
+		require_same_search(greedy, text);
+		require_same_search(long_literal, text);
+	}
+
+	const std::string_view source = "local t = {} --[[ one ]] t.x = 1 --[[ two ]]";
+	const auto comments = utils::find_all(comment, utils::buffer::view<const char>(source.data(), source.size()));
+	REQUIRE(comments.size() == 2);
+	REQUIRE(std::string_view(comments[1].data(), comments[1].size()) == "--[[");
+	REQUIRE(comments[1].data() - source.data() == 33);
+	REQUIRE(!utils::find(comment, utils::buffer::view<const char>(source.data(), 16)));
+}
+
+TEST_CASE("utils regex over chunked items", "[utils], [regex], [stream]")
+{
+	const auto& match = utils::match;
+	constexpr auto name = (match('a', 'z') | match("_")) & *(match('a', 'z') | match('0', '9'));
+	constexpr auto spaces = +match[" \t\n"];
+	constexpr auto arrow = match("->") | match("-");
+	constexpr auto token = name | spaces | arrow;
+
+	const std::string_view probe = "ab-";
+	bool reached = false;
+	const char* it = probe.data();
+	REQUIRE(name.scan(it, utils::regex_bound<char>(probe.data() + 2, reached)));
+	REQUIRE(reached);
+	reached = false;
+	it = probe.data() + 2;
+	REQUIRE(arrow.scan(it, utils::regex_bound<char>(probe.data() + 3, reached)));
+	REQUIRE(reached);
+	reached = false;
+	it = probe.data();
+	REQUIRE(spaces.scan(it, utils::regex_bound<char>(probe.data() + 3, reached)) == false);
+	REQUIRE(!reached);
+
+	const std::string text = "alpha -> beta_2\n\t-gamma  x->y->zeta";
+	std::vector<std::size_t> expected;
+	for(auto position = text.data(), end = text.data() + text.size(); position != end; expected.push_back(position - text.data()))
+		REQUIRE(token.scan(position, end));
+	for(std::size_t size: {1u, 2u, 3u, 5u, 64u}) {
+		utils::items chunks = utils::stream::chunked(text, size);
+		std::vector<std::size_t> offsets;
+		std::size_t offset = 0;
+		for(auto position = chunks.begin(); position != chunks.end(); offsets.push_back(offset)) {
+			auto copy = position;
+			REQUIRE(utils::scan(token, position, chunks.end()));
+			std::size_t consumed = 0;
+			for(; copy != position; ++copy)
+				++consumed;
+			REQUIRE(consumed > 0);
+			offset += consumed;
+		}
+		REQUIRE(offsets == expected);
+		REQUIRE(chunks.retained() == 0);
+	}
+
+	utils::items chunks = utils::stream::chunked("ab$", 2);
+	auto position = chunks.begin();
+	REQUIRE(utils::scan(name, position, chunks.end()));
+	REQUIRE(static_cast<char>(*position) == '$');
+	REQUIRE(!utils::scan(name, position, chunks.end()));
+	REQUIRE(static_cast<char>(*position) == '$');
+
+	const std::string word(1000, 'a');
+	for(const std::string& source: {word + "-", word}) {
+		utils::items pieces = utils::stream::chunked(source, 3);
+		auto at = pieces.begin();
+		REQUIRE(utils::scan(name, at, pieces.end()));
+		std::size_t rest = 0;
+		for(; at != pieces.end(); ++at)
+			++rest;
+		REQUIRE(rest == source.size() - word.size());
+	}
+}
+
+TEST_CASE("utils regex resumes across chunks", "[utils], [regex], [stream], [dfa]")
+{
+	const auto& match = utils::match;
+	constexpr auto symbol = match('a', 'z') | match('A', 'Z') | match("_");
+	constexpr auto digit = match('0', '9');
+	constexpr auto identifier = symbol & *(symbol | digit);
+	constexpr auto number = +digit & !(match(".") & *digit);
+	constexpr auto space = +match[" \t\n"];
+	constexpr auto dfa = utils::compile(identifier | number | space);
+	static_assert(utils::regex_resumable_v<std::remove_const_t<decltype(dfa)>>);
+	static_assert(!utils::regex_resumable_v<std::remove_const_t<decltype(identifier)>>);
+
+	const std::string_view parts[] = {"some_ide", "ntifier_01", "23 x"};
+	const auto before = allocations;
+	auto state = dfa.resumable();
+	const char* it = parts[0].data();
+	REQUIRE(!dfa.resume(state, it, parts[0].data() + parts[0].size()));
+	REQUIRE(it == parts[0].data() + parts[0].size());
+	it = parts[1].data();
+	REQUIRE(!dfa.resume(state, it, parts[1].data() + parts[1].size()));
+	it = parts[2].data();
+	REQUIRE(dfa.resume(state, it, parts[2].data() + parts[2].size()));
+	REQUIRE(allocations == before);
+	REQUIRE(state.done());
+	REQUIRE(*it == ' ');
+	REQUIRE(state.consumed() == 20);
+	REQUIRE(state.length() == 20u);
+
+	constexpr auto prefix = utils::compile(match("ab") | match("abcd"));
+	auto partial = prefix.resumable();
+	const std::string_view head = "ab", tail = "cx";
+	it = head.data();
+	REQUIRE(!prefix.resume(partial, it, head.data() + head.size()));
+	it = tail.data();
+	REQUIRE(prefix.resume(partial, it, tail.data() + tail.size()));
+	REQUIRE(partial.consumed() == 3);
+	REQUIRE(partial.length() == 2u);
+	partial = prefix.resumable();
+	it = tail.data();
+	REQUIRE(prefix.resume(partial, it, tail.data() + tail.size()));
+	REQUIRE(!partial.length());
+	partial = prefix.resumable();
+	it = head.data();
+	REQUIRE(!prefix.resume(partial, it, head.data() + head.size()));
+	REQUIRE(!partial.done());
+	REQUIRE(partial.length() == 2u);
+
+	const std::string text = "alpha 42 beta_2\n\t3.14  x y1 zeta";
+	std::vector<std::size_t> expected;
+	for(auto position = text.data(), end = text.data() + text.size(); position != end; expected.push_back(position - text.data()))
+		REQUIRE(dfa.scan(position, end));
+	for(std::size_t size: {1u, 2u, 3u, 5u, 64u}) {
+		utils::items chunks = utils::stream::chunked(text, size);
+		std::vector<std::size_t> offsets;
+		std::size_t offset = 0;
+		for(auto position = chunks.begin(); position != chunks.end(); offsets.push_back(offset)) {
+			auto copy = position;
+			REQUIRE(utils::scan(dfa, position, chunks.end()));
+			for(; copy != position; ++copy)
+				++offset;
+		}
+		REQUIRE(offsets == expected);
+		REQUIRE(chunks.retained() == 0);
+	}
+}
+
 namespace {
 
 	struct null_array_t {} constexpr null_array;
@@ -398,3 +998,139 @@ struct converter<unsigned>
 			return number_range(boost::lexical_cast<std::string>(value / 1000'000'000f), 'G');
 	}
 };*/
+
+TEST_CASE("utils regex profiling", "[utils], [regex], [profile]")
+{
+	const auto& match = utils::match;
+	constexpr auto name = utils::named("name", (match('a', 'z') | match("_")) & *match('a', 'z'));
+	constexpr auto number = +match('0', '9') & !(match(".") & +match('0', '9'));
+	constexpr auto arrow = match("->") | match("-");
+	constexpr auto token = name | number | arrow | +match[" "];
+	static_assert(utils::compile(name).size() == utils::compile((match('a', 'z') | match("_")) & *match('a', 'z')).size());
+	REQUIRE(name("abc"));
+	REQUIRE(!name("1"));
+
+	utils::regex_profile profile;
+#if !defined(UTILS_REGEX_PROFILE)
+	static_assert(std::is_same_v<decltype(utils::profile(token, profile)), std::remove_const_t<decltype(token)>>);
+	REQUIRE(profile.size() == 0);
+#endif
+	const auto profiled = utils::instrument(token, profile);
+	REQUIRE(profile.size() == 19);
+	REQUIRE(profile[0].label == "match_or_t");
+	REQUIRE(profile[1].label == "name");
+	REQUIRE(profile[1].depth == 1);
+	REQUIRE(profile[3].label == "match_range_t 'a'-'z'");
+	REQUIRE(profile[15].label == "match_sequence_t \"->\"");
+	REQUIRE(profile[15].depth == 1);
+	REQUIRE(profile[18].label == "match_anyof_t [ ]");
+
+	const std::string text = "ab 12.x";
+	std::vector<std::size_t> lengths;
+	const char* it = text.data();
+	const char* const end = text.data() + text.size();
+	for(const char* start = it; profiled.scan(it, end); start = it)
+		lengths.push_back(it - start);
+	REQUIRE(lengths == std::vector<std::size_t>{2, 1, 2});
+	REQUIRE(*it == '.');
+
+	const auto counters = [&profile](std::size_t index) {
+		const auto& entry = profile[index].counters;
+		return std::make_tuple(entry.attempts, entry.successes, entry.consumed, entry.examined);
+	};
+	REQUIRE(counters(0) == std::make_tuple(4, 3, 5, 1));
+	REQUIRE(counters(1) == std::make_tuple(1, 1, 2, 0));
+	REQUIRE(counters(7) == std::make_tuple(1, 1, 2, 0));
+	REQUIRE(counters(10) == std::make_tuple(1, 1, 0, 0));
+	REQUIRE(counters(11) == std::make_tuple(1, 0, 0, 2));
+	REQUIRE(counters(12) == std::make_tuple(1, 1, 1, 0));
+	REQUIRE(counters(13) == std::make_tuple(1, 0, 0, 1));
+	REQUIRE(counters(15) == std::make_tuple(0, 0, 0, 0));
+
+	std::ostringstream report;
+	report << profile;
+	REQUIRE(report.str().find("    name\n") != std::string::npos);
+	profile.reset();
+	REQUIRE(counters(0) == std::make_tuple(0, 0, 0, 0));
+	REQUIRE(profiled("ab"));
+	REQUIRE(!profiled(".x"));
+}
+
+TEST_CASE("utils regex memoized rules", "[utils], [regex], [memo]")
+{
+	const auto& match = utils::match;
+	utils::regex_profile profile;
+	const auto name = utils::instrument(+match('a', 'z'), profile);
+	const auto term = utils::memo(1, name & *(match(".") & name));
+	const auto statement = (term & match("(") & match(")")) | (term & match("[") & match("]")) | (term & match("=")) | term;
+	const auto attempts = [&profile] {
+		const auto count = profile[0].counters.attempts;
+		profile.reset();
+		return count;
+	};
+
+	const std::string text = "a.b.c=";
+	const char* it = text.data();
+	const char* const end = text.data() + text.size();
+	REQUIRE(statement.scan(it, end));
+	REQUIRE(it == end);
+	REQUIRE(attempts() == 9);
+
+	utils::regex_memo memo;
+	it = text.data();
+	REQUIRE(utils::scan(statement, it, end, memo));
+	REQUIRE(it == end);
+	REQUIRE(attempts() == 3);
+	REQUIRE(memo.size() == 1);
+
+	it = text.data();
+	const auto result = utils::parse(statement, it, end, memo);
+	REQUIRE(result);
+	REQUIRE(it == end);
+	REQUIRE(result->index() == 2);
+	REQUIRE(attempts() == 3);
+	it = text.data();
+	const auto value = utils::parse(term, it, end, memo);
+	REQUIRE(value);
+	REQUIRE(*it == '=');
+	REQUIRE(std::get<0>(*value) == std::vector<char>{'a'});
+	REQUIRE(std::get<1>(*value).size() == 2);
+	REQUIRE(std::get<1>(std::get<1>(*value)[1]) == std::vector<char>{'c'});
+	REQUIRE(attempts() == 3);
+
+	const std::string other = "x.y[]";
+	it = other.data();
+	REQUIRE(utils::parse(statement, it, other.data() + other.size(), memo));
+	REQUIRE(it == other.data() + other.size());
+	REQUIRE(attempts() == 2);
+
+	const auto field = utils::memo(2, name & match("."));
+	const auto access = (field & match("(")) | (field & match("[")) | (name & match(";"));
+	const std::string bare = "a;";
+	it = bare.data();
+	REQUIRE(utils::scan(access, it, bare.data() + bare.size(), memo));
+	REQUIRE(it == bare.data() + bare.size());
+	REQUIRE(attempts() == 2);
+	it = bare.data();
+	REQUIRE(!utils::scan(access, it, bare.data() + 1, memo));
+	REQUIRE(it == bare.data());
+	REQUIRE(attempts() == 2);
+
+	const std::string words = [] {
+		std::string words;
+		for(char c = 'a'; c <= 'z'; ++c)
+			words += std::string(1, c) + c + '.';
+		return words + "z";
+	}();
+	it = words.data();
+	REQUIRE(utils::scan(+(field | name), it, words.data() + words.size(), memo));
+	REQUIRE(it == words.data() + words.size());
+	REQUIRE(memo.size() == 27);
+	REQUIRE(term("a.b"));
+	REQUIRE(!term("a."));
+
+	constexpr auto word = utils::memo(3, match("ab") & match("c"));
+	REQUIRE(word == utils::memo(3, match("ab") & match("c")));
+	REQUIRE(!(word == utils::memo(4, match("ab") & match("c"))));
+	REQUIRE(word(*word("abc")) == "abc");
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <utils/regex/bitset.hpp>
+#include <utils/regex/bound.hpp>
+
+namespace utils {
+
+	// Each root dispatches its first byte through a table; deeper children are
+	// kept as a sibling list sorted by byte. Once a single literal remains
+	// below a node, its tail is compared straight from the byte pool.
+	template<std::size_t Capacity, std::size_t Roots = 1>
+	class regex_trie
+	{
+		static_assert(Capacity < std::numeric_limits<std::uint16_t>::max(), "too many literals in one trie");
+		struct node
+		{
+			std::uint8_t byte = 0;
+			std::uint16_t child = 0;
+			std::uint16_t sibling = 0;
+			std::uint16_t terminal = 0;
+			std::uint16_t least = std::numeric_limits<std::uint16_t>::max();
+			std::uint16_t literals = 0;
+			std::uint16_t tail = 0;
+			std::uint16_t remain = 0;
+		};
+		std::array<std::array<std::uint16_t, 256>, Roots> heads{};
+		std::array<node, Capacity + 1> nodes{};
+		std::array<std::uint8_t, Capacity> pool{};
+		std::size_t count = 1;
+		std::size_t pooled = 0;
+	public:
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+	public:
+		constexpr regex_trie() noexcept = default;
+		regex_trie(const regex_trie&) = default;
+		regex_trie& operator=(const regex_trie&) = default;
+	private:
+		constexpr std::size_t step(std::size_t at, std::uint8_t byte) const noexcept
+		{
+			for(std::size_t next = nodes[at].child; next; next = nodes[next].sibling)
+				if(nodes[next].byte >= byte)
+					return nodes[next].byte == byte ? next : 0;
+			return 0;
+		}
+		template<class Begin, class End>
+		constexpr bool tail(const node& current, Begin& next, const End& end) const
+		{
+			for(std::size_t i = 0; i < current.remain; ++i, ++next)
+				if(details::regex_end<End>::hit(next, end) || regex_byte(*next) != pool[current.tail + i])
+					return false;
+			return true;
+		}
+		constexpr std::size_t add(std::uint8_t byte, std::size_t sibling) noexcept
+		{
+			nodes[count] = node{byte, 0, static_cast<std::uint16_t>(sibling), 0};
+			return count++;
+		}
+	public:
+		constexpr std::size_t size() const noexcept
+		{
+			return count - 1;
+		}
+		template<class T>
+		constexpr void insert(std::size_t root, const T* values, std::size_t size, std::size_t value) noexcept
+		{
+			if(!size)
+				return;
+			const auto terminal = static_cast<std::uint16_t>(value + 1);
+			const std::size_t start = pooled;
+			for(std::size_t i = 0; i < size; ++i)
+				pool[pooled++] = regex_byte(values[i]);
+			const auto enter = [&](std::size_t at, std::size_t depth) {
+				auto& current = nodes[at];
+				current.least = std::min(current.least, terminal);
+				if(!current.literals++) {
+					current.tail = static_cast<std::uint16_t>(start + depth);
+					current.remain = static_cast<std::uint16_t>(size - depth);
+				}
+			};
+			auto& head = heads[root][regex_byte(values[0])];
+			if(!head)
+				head = static_cast<std::uint16_t>(add(regex_byte(values[0]), 0));
+			std::size_t at = head;
+			enter(at, 1);
+			for(std::size_t i = 1; i < size; ++i) {
+				const auto byte = regex_byte(values[i]);
+				std::size_t previous = 0;
+				std::size_t next = nodes[at].child;
+				while(next && nodes[next].byte < byte) {
+					previous = next;
+					next = nodes[next].sibling;
+				}
+				if(!next || nodes[next].byte != byte) {
+					const auto created = static_cast<std::uint16_t>(add(byte, next));
+					if(previous)
+						nodes[previous].sibling = created;
+					else
+						nodes[at].child = created;
+					next = created;
+				}
+				at = next;
+				enter(at, i + 1);
+			}
+			if(!nodes[at].terminal)
+				nodes[at].terminal = terminal;
+		}
+		// Returns the value of the literal chosen from the root and moves past
+		// it: the longest one, or the one inserted with the smallest value.
+		template<bool Longest, class Begin, class End>
+		constexpr std::size_t find(std::size_t root, Begin& it, End end) const
+		{
+			if(details::regex_end<End>::hit(it, end))
+				return npos;
+			std::size_t at = heads[root][regex_byte(*it)];
+			if(!at)
+				return npos;
+			Begin next = it;
+			++next;
+			if(nodes[at].literals == 1) {
+				if(!tail(nodes[at], next, end))
+					return npos;
+				it = next;
+				return nodes[at].least - 1;
+			}
+			std::size_t found = 0;
+			Begin stop = it;
+			for(;;) {
+				if(const auto& current = nodes[at]; current.literals == 1) {
+					if(tail(current, next, end) && (Longest || !found || current.least < found)) {
+						found = current.least;
+						stop = next;
+					}
+					break;
+				}
+				if(const std::size_t terminal = nodes[at].terminal; terminal && (Longest || !found || terminal < found)) {
+					found = terminal;
+					stop = next;
+				}
+				if(!nodes[at].child || details::regex_end<End>::hit(next, end))
+					break;
+				at = step(at, regex_byte(*next));
+				if(!at)
+					break;
+				if constexpr(!Longest) {
+					if(found && nodes[at].least > found)
+						break;
+				}
+				++next;
+			}
+			if(!found)
+				return npos;
+			it = stop;
+			return found - 1;
+		}
+	};
+
+}
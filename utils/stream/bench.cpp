@@ -0,0 +1,74 @@
+#include <utils/bench.hpp>
+#include <utils/stream/fstream.hpp>
+#include <utils/stream/items.hpp>
+#include <utils/stream/lines.hpp>
+#if defined(__unix__) || defined(__APPLE__)
+#	include <utils/stream/fdstream.hpp>
+#endif
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int main(int argc, const char* argv[])
+{
+	utils::bench::suite suite("utils-stream", argc, argv);
+	constexpr std::size_t size = 64u * 1024u * 1024u;
+	const fs::path path = fs::temp_directory_path() / "utils-stream-bench.data";
+	{
+		const std::string line = "local value = table.concat({1, 2, 3}, ', ') -- bench line\n";
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		for(std::size_t written = 0; written < size; written += line.size())
+			file << line;
+	}
+	const auto length = fs::file_size(path);
+	std::vector<std::byte> memory(length);
+	std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(memory.data()), memory.size());
+
+	suite.run("stream/memory", length, utils::bench::unit::bytes, [&] {
+		return std::count(memory.begin(), memory.end(), std::byte('\n'));
+	});
+
+	suite.run("stream/ifstream", length, utils::bench::unit::bytes, [&] {
+		utils::stream::ifstream file(path, {utils::stream::ifstream_options::access::sequential});
+		std::size_t newlines = 0;
+		while(file.closed()) {
+			const auto chunk = file.get();
+			newlines += std::count(chunk.begin(), chunk.end(), std::byte('\n'));
+		}
+		return newlines;
+	});
+	suite.run("stream/items", length, utils::bench::unit::bytes, [&] {
+		utils::items bytes = utils::stream::ifstream(path, {utils::stream::ifstream_options::access::sequential});
+		std::size_t newlines = 0;
+		for(auto it = bytes.begin(); it != bytes.end(); ++it)
+			newlines += *it == std::byte('\n');
+		return newlines;
+	});
+	suite.run("stream/lines", length, utils::bench::unit::bytes, [&] {
+		utils::stream::line_indexer file(utils::stream::ifstream(path, {utils::stream::ifstream_options::access::sequential}));
+		while(file.closed())
+			file.get();
+		return file.lines().line_count();
+	});
+#if defined(__unix__) || defined(__APPLE__)
+	suite.run("stream/fdstream", length, utils::bench::unit::bytes, [&] {
+		utils::stream::fdstream file(path);
+		std::size_t newlines = 0;
+		while(file.closed()) {
+			const auto chunk = file.get();
+			newlines += std::count(chunk.begin(), chunk.end(), std::byte('\n'));
+		}
+		return newlines;
+	});
+#endif
+	fs::remove(path);
+	suite.compare("stream/ifstream", "stream/memory");
+	suite.compare("stream/items", "stream/ifstream");
+	suite.compare("stream/lines", "stream/ifstream");
+	suite.compare("stream/fdstream", "stream/ifstream");
+	return suite.finish();
+}
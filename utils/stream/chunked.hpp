@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <utils/buffer.hpp>
+
+namespace utils::stream {
+
+	// Hands a copy of some text out in slices of a fixed size, so chunk
+	// boundaries land where a test or bench wants them.
+	class chunked
+	{
+		buffer::owner<const std::byte> source;
+		std::size_t size;
+	public:
+		chunked(std::string_view text, std::size_t size)
+		: source(buffer::owner<const std::byte>::copy(reinterpret_cast<const std::byte*>(text.data()), text.size()))
+		, size(size)
+		{}
+	public:
+		using value_type = buffer::owner<const std::byte>;
+		value_type get()
+		{
+			return source.first(size);
+		}
+		bool closed() const noexcept
+		{
+			return source.size();
+		}
+		void close()
+		{
+			source = value_type();
+		}
+	};
+
+}
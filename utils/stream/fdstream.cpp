@@ -0,0 +1,506 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <system_error>
+#include <utility>
+#include <utils/stream/prefetch.hpp>
+#include "fdstream.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <linux/io_uring.h>
+#	if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#		define UTILS_STREAM_IO_URING 1
+#	endif
+#endif
+
+namespace utils::stream {
+
+	class fdstream::reader
+	{
+	public:
+		virtual buffer::owner<const std::byte> next() = 0;
+		virtual fdstream_options::engine engine() const noexcept = 0;
+		virtual void interrupt() noexcept {}
+		virtual ~reader() = default;
+	};
+
+	namespace {
+
+		[[noreturn]] void fail(const char* what)
+		{
+			throw std::system_error(errno, std::generic_category(), what);
+		}
+
+		class descriptor
+		{
+			int fd;
+			bool owned;
+		public:
+			descriptor(int fd, bool owned) noexcept
+			: fd(fd), owned(owned)
+			{}
+			descriptor(descriptor&& other) noexcept
+			: fd(std::exchange(other.fd, -1)), owned(other.owned)
+			{}
+			descriptor(const descriptor&) = delete;
+			descriptor& operator=(const descriptor&) = delete;
+			~descriptor()
+			{
+				if(owned && fd >= 0)
+					::close(fd);
+			}
+		public:
+			int get() const noexcept
+			{
+				return fd;
+			}
+			bool seekable() const noexcept
+			{
+				struct stat status;
+				return ::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && ::lseek(fd, 0, SEEK_CUR) >= 0;
+			}
+		};
+
+		class wakeup
+		{
+			int fds[2] = {-1, -1};
+		public:
+			wakeup()
+			{
+				if(::pipe(fds) != 0)
+					fail("utils::stream::fdstream: pipe");
+			}
+			wakeup(const wakeup&) = delete;
+			wakeup& operator=(const wakeup&) = delete;
+			~wakeup()
+			{
+				::close(fds[0]);
+				::close(fds[1]);
+			}
+		public:
+			int get() const noexcept
+			{
+				return fds[0];
+			}
+			void notify() noexcept
+			{
+				const char signal = 0;
+				while(::write(fds[1], &signal, 1) < 0 && errno == EINTR);
+			}
+		};
+
+		class threaded_reader final: public fdstream::reader
+		{
+			descriptor source;
+			const bool seekable;
+			off_t offset = 0;
+			wakeup signal;
+			prefetcher reader;
+		private:
+			bool wait_readable()
+			{
+				pollfd events[2] = {{source.get(), POLLIN, 0}, {signal.get(), POLLIN, 0}};
+				while(::poll(events, 2, -1) < 0)
+					if(errno != EINTR)
+						fail("utils::stream::fdstream: poll");
+				return !events[1].revents;
+			}
+			std::size_t read_some(std::byte* data, std::size_t size)
+			{
+				for(;;) {
+					if(!seekable && !wait_readable())
+						return 0;
+					const auto count = seekable ? ::pread(source.get(), data, size, offset) : ::read(source.get(), data, size);
+					if(count >= 0) {
+						offset += count;
+						return static_cast<std::size_t>(count);
+					}
+					if(errno != EINTR && errno != EAGAIN)
+						fail("utils::stream::fdstream: read");
+				}
+			}
+			std::size_t fill(std::byte* data, std::size_t size)
+			{
+				std::size_t filled = 0;
+				while(filled < size) {
+					const auto count = read_some(data + filled, size - filled);
+					filled += count;
+					if(!count || !seekable)
+						break;
+				}
+				return filled;
+			}
+		public:
+			threaded_reader(descriptor source, const fdstream_options& options)
+			: source(std::move(source))
+			, seekable(this->source.seekable())
+			, offset(seekable ? ::lseek(this->source.get(), 0, SEEK_CUR) : 0)
+			, reader(options.chunk_size, options.depth, [this](std::byte* data, std::size_t size) { return fill(data, size); }, [this] { signal.notify(); })
+			{}
+		public:
+			buffer::owner<const std::byte> next() override
+			{
+				return reader.next();
+			}
+			fdstream_options::engine engine() const noexcept override
+			{
+				return fdstream_options::engine::read;
+			}
+			void interrupt() noexcept override
+			{
+				reader.stop();
+			}
+		};
+
+#if defined(UTILS_STREAM_IO_URING)
+		class ring
+		{
+			int fd = -1;
+			void* sq = MAP_FAILED;
+			std::size_t sq_size = 0;
+			void* cq = MAP_FAILED;
+			std::size_t cq_size = 0;
+			io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+			std::size_t sqes_size = 0;
+			unsigned* sq_tail = nullptr;
+			unsigned* sq_mask = nullptr;
+			unsigned* sq_array = nullptr;
+			unsigned* cq_head = nullptr;
+			unsigned* cq_tail = nullptr;
+			unsigned* cq_mask = nullptr;
+			io_uring_cqe* cqes = nullptr;
+		private:
+			template<class T>
+			static T* at(void* base, unsigned offset) noexcept
+			{
+				return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+			}
+			void* map(std::size_t size, off_t offset)
+			{
+				void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+				if(address == MAP_FAILED)
+					fail("utils::stream::fdstream: io_uring mmap");
+				return address;
+			}
+			void enter(unsigned submit, unsigned wait, unsigned flags)
+			{
+				while(::syscall(__NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0) < 0)
+					if(errno != EINTR)
+						fail("utils::stream::fdstream: io_uring_enter");
+			}
+			void release() noexcept
+			{
+				if(sqes != MAP_FAILED)
+					::munmap(sqes, sqes_size);
+				if(cq != MAP_FAILED && cq != sq)
+					::munmap(cq, cq_size);
+				if(sq != MAP_FAILED)
+					::munmap(sq, sq_size);
+				if(fd >= 0)
+					::close(fd);
+			}
+		public:
+			explicit ring(unsigned entries)
+			{
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+				fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+				if(fd < 0)
+					fail("utils::stream::fdstream: io_uring_setup");
+				try {
+					sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+					cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+					if(params.features & IORING_FEAT_SINGLE_MMAP)
+						sq_size = cq_size = std::max(sq_size, cq_size);
+					sq = map(sq_size, IORING_OFF_SQ_RING);
+					cq = params.features & IORING_FEAT_SINGLE_MMAP ? sq : map(cq_size, IORING_OFF_CQ_RING);
+					sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+					sqes = static_cast<io_uring_sqe*>(map(sqes_size, IORING_OFF_SQES));
+				} catch(...) {
+					release();
+					throw;
+				}
+				sq_tail = at<unsigned>(sq, params.sq_off.tail);
+				sq_mask = at<unsigned>(sq, params.sq_off.ring_mask);
+				sq_array = at<unsigned>(sq, params.sq_off.array);
+				cq_head = at<unsigned>(cq, params.cq_off.head);
+				cq_tail = at<unsigned>(cq, params.cq_off.tail);
+				cq_mask = at<unsigned>(cq, params.cq_off.ring_mask);
+				cqes = at<io_uring_cqe>(cq, params.cq_off.cqes);
+			}
+			ring(const ring&) = delete;
+			ring& operator=(const ring&) = delete;
+			~ring()
+			{
+				release();
+			}
+		public:
+			void read(int file, iovec* vector, off_t offset, std::uint64_t tag)
+			{
+				const auto tail = *sq_tail;
+				const auto index = tail & *sq_mask;
+				auto& entry = sqes[index];
+				std::memset(&entry, 0, sizeof(entry));
+				entry.opcode = IORING_OP_READV;
+				entry.fd = file;
+				entry.addr = reinterpret_cast<std::uintptr_t>(vector);
+				entry.len = 1;
+				entry.off = static_cast<std::uint64_t>(offset);
+				entry.user_data = tag;
+				sq_array[index] = index;
+				__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+				enter(1, 0, 0);
+			}
+			std::pair<std::uint64_t, int> wait()
+			{
+				for(;;) {
+					const auto head = *cq_head;
+					if(head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+						const auto& entry = cqes[head & *cq_mask];
+						std::pair<std::uint64_t, int> result(entry.user_data, entry.res);
+						__atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+						return result;
+					}
+					enter(0, 1, IORING_ENTER_GETEVENTS);
+				}
+			}
+		};
+
+		class uring_reader final: public fdstream::reader
+		{
+			struct request
+			{
+				buffer_pool::slot slot;
+				iovec vector;
+				off_t offset;
+				int result = 0;
+				bool done = false;
+			public:
+				request(buffer_pool::slot slot, off_t offset) noexcept
+				: slot(std::move(slot)), offset(offset)
+				{
+					vector.iov_base = this->slot.data();
+					vector.iov_len = this->slot.capacity();
+				}
+			};
+			descriptor source;
+			off_t offset;
+			buffer_pool pool;
+			const std::size_t depth;
+			ring queue;
+			std::deque<request> inflight;
+			std::uint64_t first = 0;
+			bool exhausted = false;
+		private:
+			void submit()
+			{
+				while(!exhausted && inflight.size() < depth) {
+					auto& entry = inflight.emplace_back(pool.acquire(), offset);
+					queue.read(source.get(), &entry.vector, offset, first + inflight.size() - 1);
+					offset += static_cast<off_t>(entry.vector.iov_len);
+				}
+			}
+			void reap()
+			{
+				const auto [tag, result] = queue.wait();
+				auto& entry = inflight[tag - first];
+				entry.result = result;
+				entry.done = true;
+			}
+			std::size_t complete(request& entry)
+			{
+				if(entry.result < 0) {
+					errno = -entry.result;
+					fail("utils::stream::fdstream: io_uring read");
+				}
+				auto filled = static_cast<std::size_t>(entry.result);
+				while(filled && filled < entry.slot.capacity()) {
+					const auto count = ::pread(source.get(), entry.slot.data() + filled, entry.slot.capacity() - filled, entry.offset + static_cast<off_t>(filled));
+					if(count < 0 && errno == EINTR)
+						continue;
+					if(count < 0)
+						fail("utils::stream::fdstream: read");
+					if(!count)
+						break;
+					filled += static_cast<std::size_t>(count);
+				}
+				if(filled < entry.slot.capacity())
+					exhausted = true;
+				return filled;
+			}
+		public:
+			uring_reader(descriptor source, const fdstream_options& options)
+			: source(std::move(source))
+			, offset(::lseek(this->source.get(), 0, SEEK_CUR))
+			, pool(options.chunk_size, options.depth + 1)
+			, depth(options.depth)
+			, queue(static_cast<unsigned>(options.depth))
+			{}
+			~uring_reader() override
+			{
+				try {
+					for(auto& entry: inflight)
+						while(!entry.done)
+							reap();
+				} catch(...) {
+				}
+			}
+		public:
+			buffer::owner<const std::byte> next() override
+			{
+				submit();
+				if(inflight.empty())
+					return {};
+				while(!inflight.front().done)
+					reap();
+				const auto filled = complete(inflight.front());
+				auto chunk = std::move(inflight.front().slot).seal(filled);
+				inflight.pop_front();
+				++first;
+				if(!filled) {
+					for(auto& entry: inflight)
+						while(!entry.done)
+							reap();
+					return {};
+				}
+				submit();
+				return chunk;
+			}
+			fdstream_options::engine engine() const noexcept override
+			{
+				return fdstream_options::engine::io_uring;
+			}
+		};
+#endif
+
+		std::unique_ptr<fdstream::reader> make_reader(descriptor source, fdstream_options options)
+		{
+			if(!options.chunk_size)
+				options.chunk_size = fdstream_options().chunk_size;
+			options.depth = std::max<std::size_t>(options.depth, 1);
+			const auto seekable = source.seekable();
+			switch(options.backend) {
+				case fdstream_options::engine::io_uring:
+					if(!seekable)
+						throw std::system_error(make_error_code(std::errc::invalid_seek), "utils::stream::fdstream: io_uring needs a seekable file");
+#if defined(UTILS_STREAM_IO_URING)
+					return std::make_unique<uring_reader>(std::move(source), options);
+#else
+					throw std::system_error(make_error_code(std::errc::function_not_supported), "utils::stream::fdstream: io_uring");
+#endif
+				case fdstream_options::engine::automatic:
+#if defined(UTILS_STREAM_IO_URING)
+					if(seekable && fdstream::io_uring_supported())
+						return std::make_unique<uring_reader>(std::move(source), options);
+#endif
+					[[fallthrough]];
+				default:
+					return std::make_unique<threaded_reader>(std::move(source), options);
+			}
+		}
+
+		int open(const std::filesystem::path& path)
+		{
+			const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if(fd < 0)
+				throw std::system_error(errno, std::generic_category(), path.string());
+			return fd;
+		}
+	}
+
+	fdstream::fdstream(int fd, const fdstream_options& options, bool owned)
+	: backend(make_reader(descriptor(fd, owned), options))
+	{}
+
+	fdstream::fdstream(const std::filesystem::path& path, const fdstream_options& options)
+	: fdstream(open(path), options, true)
+	{}
+
+	fdstream::fdstream(fdstream&&) noexcept = default;
+	fdstream& fdstream::operator=(fdstream&&) noexcept = default;
+	fdstream::~fdstream() = default;
+
+	bool fdstream::io_uring_supported() noexcept
+	{
+#if defined(UTILS_STREAM_IO_URING)
+		static const bool supported = [] {
+			try {
+				ring probe(1);
+				return true;
+			} catch(const std::system_error&) {
+				return false;
+			}
+		}();
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	fdstream_options::engine fdstream::engine() const noexcept
+	{
+		return backend ? backend->engine() : fdstream_options::engine::read;
+	}
+
+	bool fdstream::fill() const noexcept
+	{
+		if(current.empty() && backend && !ended && !error) {
+			try {
+				current = backend->next();
+				ended = current.empty();
+			} catch(...) {
+				error = std::current_exception();
+			}
+		}
+		return !current.empty() || error;
+	}
+
+	void fdstream::get(utils::buffer::view<std::byte>& view)
+	{
+		std::size_t filled = 0;
+		while(filled < view.size() && (!filled || !current.empty()) && fill()) {
+			if(error)
+				std::rethrow_exception(std::exchange(error, nullptr));
+			auto chunk = current.first(view.size() - filled);
+			std::copy(chunk.begin(), chunk.end(), view.data() + filled);
+			filled += chunk.size();
+		}
+		view = view.first(filled);
+	}
+
+	utils::buffer::owner<const std::byte> fdstream::get()
+	{
+		fill();
+		if(error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+		return std::exchange(current, buffer::owner<const std::byte>());
+	}
+
+	void fdstream::interrupt() noexcept
+	{
+		if(backend)
+			backend->interrupt();
+	}
+
+	void fdstream::close()
+	{
+		backend.reset();
+		current = buffer::owner<const std::byte>();
+		error = nullptr;
+	}
+
+	bool fdstream::closed() const noexcept
+	{
+		return fill();
+	}
+}
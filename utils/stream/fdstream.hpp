@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <utils/stream/istream.hpp>
+#include <utils/stream/pool.hpp>
+
+namespace utils::stream {
+
+	struct fdstream_options
+	{
+		enum class engine { automatic, read, io_uring };
+		engine backend = engine::automatic;
+		std::size_t chunk_size = 1024u * 1024u;
+		std::size_t depth = 2;
+	};
+
+	class fdstream: public istream<std::byte>
+	{
+	public:
+		class reader;
+	private:
+		mutable std::unique_ptr<reader> backend;
+		mutable buffer::owner<const std::byte> current;
+		mutable bool ended = false;
+		mutable std::exception_ptr error;
+		bool fill() const noexcept;
+	public:
+		fdstream(int fd, const fdstream_options& options = {}, bool owned = false);
+		fdstream(const std::filesystem::path& path, const fdstream_options& options = {});
+		fdstream(fdstream&&) noexcept;
+		fdstream& operator=(fdstream&&) noexcept;
+		~fdstream() override;
+	public:
+		static bool io_uring_supported() noexcept;
+		fdstream_options::engine engine() const noexcept;
+	public:
+		using value_type = utils::buffer::owner<const std::byte>;
+		void get(utils::buffer::view<std::byte>&) override;
+		utils::buffer::owner<const std::byte> get() override;
+		void interrupt() noexcept override;
+		void close() override;
+		bool closed() const noexcept override;
+	};
+
+}
@@ -1,34 +1,187 @@
-#include <boost/iostreams/device/mapped_file.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
 #include <system_error>
 #include "fstream.hpp"
 
-namespace bio = boost::iostreams;
+#if defined(__unix__) || defined(__APPLE__)
+#	define UTILS_STREAM_POSIX 1
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/uio.h>
+#	include <unistd.h>
+#else
+#	include <boost/iostreams/device/mapped_file.hpp>
+#endif
 
-namespace {
+namespace utils::stream {
 
-	struct ROFileMapping
+#if defined(UTILS_STREAM_POSIX)
+	class ifstream::mapping: public buffer::Resource<const std::byte>
 	{
-		bio::mapped_file_source source;
+		int fd = -1;
+		const std::byte* data = nullptr;
+		std::size_t size = 0;
+	private:
+		[[noreturn]] static void fail(const std::filesystem::path& path, int error)
+		{
+			throw std::system_error(error, std::generic_category(), path.string());
+		}
+		[[noreturn]] void abandon(const std::filesystem::path& path)
+		{
+			const auto error = errno;
+			::close(fd);
+			fail(path, error);
+		}
+		void advise(int advice) const noexcept
+		{
+			::madvise(const_cast<std::byte*>(data), size, advice);
+		}
 	public:
-		ROFileMapping(const std::filesystem::path& path)
+		mapping(const std::filesystem::path& path, const ifstream_options& options)
+		{
+			fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if(fd < 0)
+				fail(path, errno);
+			struct stat status;
+			if(::fstat(fd, &status) != 0)
+				abandon(path);
+			size = static_cast<std::size_t>(status.st_size);
+			if(!size)
+				return;
+			int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+			if(options.populate)
+				flags |= MAP_POPULATE;
+#endif
+			void* address = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+			if(address == MAP_FAILED)
+				abandon(path);
+			data = static_cast<const std::byte*>(address);
+			switch(options.advice) {
+				case ifstream_options::access::sequential:
+					advise(MADV_SEQUENTIAL);
+#if defined(POSIX_FADV_SEQUENTIAL)
+					::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+					break;
+				case ifstream_options::access::random:
+					advise(MADV_RANDOM);
+					break;
+				default:
+					break;
+			}
+			if(options.willneed)
+				advise(MADV_WILLNEED);
+#if defined(MADV_HUGEPAGE)
+			if(options.huge_pages)
+				advise(MADV_HUGEPAGE);
+#endif
+		}
+		mapping(const mapping&) = delete;
+		mapping& operator=(const mapping&) = delete;
+		~mapping()
+		{
+			if(data)
+				::munmap(const_cast<std::byte*>(data), size);
+			if(fd >= 0)
+				::close(fd);
+		}
+	public:
+		const std::byte* begin() const noexcept override
+		{
+			return data;
+		}
+		const std::byte* end() const noexcept override
+		{
+			return data + size;
+		}
+		void drop(const std::byte* from, const std::byte* to) const noexcept
+		{
+			const auto page = page_size();
+			const auto first = (static_cast<std::size_t>(from - data) + page - 1) / page * page;
+			const auto last = to == end() ? size : static_cast<std::size_t>(to - data) / page * page;
+			if(first >= last)
+				return;
+			::madvise(const_cast<std::byte*>(data) + first, last - first, MADV_DONTNEED);
+#if defined(POSIX_FADV_DONTNEED)
+			::posix_fadvise(fd, static_cast<off_t>(first), static_cast<off_t>(last - first), POSIX_FADV_DONTNEED);
+#endif
+		}
+		static std::size_t page_size() noexcept
+		{
+			return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		}
+	};
+#else
+	class ifstream::mapping: public buffer::Resource<const std::byte>
+	{
+		boost::iostreams::mapped_file_source source;
+	public:
+		mapping(const std::filesystem::path& path, const ifstream_options&)
 		: source(path.string())
 		{}
 	public:
-		const std::byte* data() const noexcept
+		const std::byte* begin() const noexcept override
 		{
 			return reinterpret_cast<const std::byte*>(source.data());
 		}
-		std::size_t size() const noexcept
+		const std::byte* end() const noexcept override
+		{
+			return begin() + source.size();
+		}
+		void drop(const std::byte*, const std::byte*) const noexcept
+		{}
+		static std::size_t page_size() noexcept
 		{
-			return source.size();
+			return boost::iostreams::mapped_file_source::alignment();
 		}
 	};
-}
+#endif
 
-namespace utils::stream {
-	ifstream::ifstream(const std::filesystem::path& path)
-	: mmap(ROFileMapping(path))
+	namespace {
+
+		template<class Mapping>
+		class dropping_chunk: public buffer::Resource<const std::byte>
+		{
+			std::shared_ptr<Mapping> file;
+			const std::byte* first;
+			const std::byte* last;
+		public:
+			dropping_chunk(std::shared_ptr<Mapping> file, const std::byte* first, const std::byte* last) noexcept
+			: file(std::move(file)), first(first), last(last)
+			{}
+			~dropping_chunk()
+			{
+				file->drop(first, last);
+			}
+		public:
+			const std::byte* begin() const noexcept override
+			{
+				return first;
+			}
+			const std::byte* end() const noexcept override
+			{
+				return last;
+			}
+		};
+	}
+
+	ifstream::ifstream(const std::filesystem::path& path, const ifstream_options& options)
+	: file(std::make_shared<mapping>(path, options))
+	, options(options)
 	{
+		if(file->begin() != file->end())
+			mmap = buffer::owner<const std::byte>(file);
+		if(!this->options.chunk_size)
+			this->options.chunk_size = ifstream_options().chunk_size;
+		if(this->options.drop_behind) {
+			const auto page = mapping::page_size();
+			this->options.chunk_size = (this->options.chunk_size + page - 1) / page * page;
+		}
 	}
 
 	void ifstream::get(utils::buffer::view<std::byte>& view)
@@ -40,17 +193,274 @@ namespace utils::stream {
 
 	utils::buffer::owner<const std::byte> ifstream::get()
 	{
-		constexpr auto chunk = 4u * 1024u * 1024u;
-		return mmap.first(chunk);
+		return get(options.chunk_size);
+	}
+
+	utils::buffer::owner<const std::byte> ifstream::get(std::size_t size)
+	{
+		auto chunk = mmap.first(size);
+		if(!options.drop_behind || chunk.empty())
+			return chunk;
+		return buffer::make<dropping_chunk<mapping>>(file, chunk.begin(), chunk.end());
 	}
 
 	void ifstream::close()
 	{
 		mmap = buffer::owner<const std::byte>();
+		file.reset();
 	}
 
 	bool ifstream::closed() const noexcept
 	{
 		return mmap.size();
 	}
-}
\ No newline at end of file
+
+#if defined(UTILS_STREAM_POSIX)
+	class ofstream::file
+	{
+		int fd = -1;
+		bool direct_ = false;
+		std::uint64_t origin = 0;
+	public:
+		static constexpr std::size_t alignment = 4096;
+	public:
+		file(const std::filesystem::path& path, const ofstream_options& options)
+		{
+			const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (options.append ? O_APPEND : O_TRUNC);
+			fd = ::open(path.c_str(), flags, 0666);
+			if(fd < 0)
+				throw std::system_error(errno, std::generic_category(), path.string());
+			if(options.append) {
+				const auto end = ::lseek(fd, 0, SEEK_END);
+				origin = end > 0 ? static_cast<std::uint64_t>(end) : 0;
+			}
+#if defined(O_DIRECT)
+			// Direct writes land at the end of the file, so appending to a file
+			// whose size is not aligned stays buffered.
+			if(options.direct && origin % alignment == 0) {
+				const int current = ::fcntl(fd, F_GETFL);
+				direct_ = current >= 0 && ::fcntl(fd, F_SETFL, current | O_DIRECT) == 0;
+			}
+#endif
+		}
+		file(const file&) = delete;
+		file& operator=(const file&) = delete;
+		~file()
+		{
+			::close(fd);
+		}
+	public:
+		bool direct() const noexcept
+		{
+			return direct_;
+		}
+		std::size_t write(const segment* segments, std::size_t count)
+		{
+			iovec vectors[64];
+			count = std::min<std::size_t>(count, std::size(vectors));
+			for(std::size_t i = 0; i < count; ++i) {
+				vectors[i].iov_base = const_cast<std::byte*>(segments[i].data);
+				vectors[i].iov_len = segments[i].size;
+			}
+			for(;;) {
+				const auto result = ::writev(fd, vectors, static_cast<int>(count));
+				if(result >= 0)
+					return static_cast<std::size_t>(result);
+				if(errno != EINTR)
+					throw std::system_error(errno, std::generic_category(), "utils::stream::ofstream: writev");
+			}
+		}
+		void truncate(std::uint64_t size)
+		{
+			if(::ftruncate(fd, static_cast<off_t>(origin + size)) != 0)
+				throw std::system_error(errno, std::generic_category(), "utils::stream::ofstream: ftruncate");
+		}
+	};
+#else
+	class ofstream::file
+	{
+		std::FILE* handle;
+	public:
+		static constexpr std::size_t alignment = 4096;
+	public:
+		file(const std::filesystem::path& path, const ofstream_options& options)
+		: handle(std::fopen(path.string().c_str(), options.append ? "ab" : "wb"))
+		{
+			if(!handle)
+				throw std::system_error(errno, std::generic_category(), path.string());
+			std::setvbuf(handle, nullptr, _IONBF, 0);
+		}
+		file(const file&) = delete;
+		file& operator=(const file&) = delete;
+		~file()
+		{
+			std::fclose(handle);
+		}
+	public:
+		bool direct() const noexcept
+		{
+			return false;
+		}
+		std::size_t write(const segment* segments, std::size_t)
+		{
+			const auto result = std::fwrite(segments->data, 1, segments->size, handle);
+			if(!result)
+				throw std::system_error(errno, std::generic_category(), "utils::stream::ofstream: fwrite");
+			return result;
+		}
+		void truncate(std::uint64_t)
+		{}
+	};
+#endif
+
+	void ofstream::aligned_delete::operator()(std::byte* data) const noexcept
+	{
+		::operator delete(data, std::align_val_t(alignment));
+	}
+
+	ofstream::ofstream(const std::filesystem::path& path, const ofstream_options& options)
+	: output(std::make_unique<file>(path, options))
+	, memory(nullptr, aligned_delete{file::alignment})
+	, capacity((std::max(options.buffer_size, file::alignment) + file::alignment - 1) / file::alignment * file::alignment)
+	, threshold(options.gather_threshold)
+	{
+		memory.reset(static_cast<std::byte*>(::operator new(capacity, std::align_val_t(file::alignment))));
+	}
+
+	ofstream::ofstream(ofstream&&) noexcept = default;
+	ofstream& ofstream::operator=(ofstream&&) noexcept = default;
+
+	ofstream::~ofstream()
+	{
+		try {
+			close();
+		} catch(...) {
+		}
+	}
+
+	void ofstream::append(const std::byte* data, std::size_t size)
+	{
+		while(size) {
+			if(used == capacity)
+				flush();
+			const auto count = std::min(size, capacity - used);
+			auto* target = memory.get() + used;
+			std::memcpy(target, data, count);
+			if(!pending.empty() && pending.back().data + pending.back().size == target)
+				pending.back().size += count;
+			else
+				pending.push_back({target, count});
+			used += count;
+			pending_size += count;
+			data += count;
+			size -= count;
+		}
+	}
+
+	void ofstream::gather(const std::byte* data, std::size_t size, std::shared_ptr<const void> keeper)
+	{
+		pending.push_back({data, size});
+		retained.push_back(std::move(keeper));
+		pending_size += size;
+		if(pending.size() >= 64 || pending_size >= capacity)
+			drain();
+	}
+
+	void ofstream::drain()
+	{
+		for(std::size_t first = 0; first < pending.size(); ) {
+			auto count = output->write(pending.data() + first, pending.size() - first);
+			++calls;
+			written += count;
+			for(; first < pending.size() && count >= pending[first].size; ++first)
+				count -= pending[first].size;
+			if(count) {
+				pending[first].data += count;
+				pending[first].size -= count;
+			}
+		}
+		pending.clear();
+		retained.clear();
+		pending_size = 0;
+		used = 0;
+	}
+
+	void ofstream::drain_direct(bool last)
+	{
+		const auto size = last ? (used + file::alignment - 1) / file::alignment * file::alignment : used / file::alignment * file::alignment;
+		std::fill(memory.get() + used, memory.get() + size, std::byte(0));
+		for(std::size_t offset = 0; offset < size; ) {
+			const segment block{memory.get() + offset, size - offset};
+			offset += output->write(&block, 1);
+			++calls;
+		}
+		const auto payload = std::min(size, used);
+		written += payload;
+		if(last && size != used) {
+			output->truncate(written);
+			++calls;
+		}
+		std::memmove(memory.get(), memory.get() + payload, used - payload);
+		used -= payload;
+		pending.clear();
+		pending_size = used;
+	}
+
+	void ofstream::put(utils::buffer::view<const std::byte>& values)
+	{
+		if(!output)
+			throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::stream::ofstream: put to a closed stream");
+		append(values.data(), values.size());
+	}
+
+	void ofstream::put(utils::buffer::owner<std::byte> chunk)
+	{
+		if(!output)
+			throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::stream::ofstream: put to a closed stream");
+		if(output->direct() || chunk.size() < threshold)
+			return append(chunk.data(), chunk.size());
+		auto keeper = std::make_shared<utils::buffer::owner<std::byte>>(std::move(chunk));
+		gather(keeper->data(), keeper->size(), keeper);
+	}
+
+	void ofstream::put(utils::buffer::owner<const std::byte> chunk)
+	{
+		if(!output)
+			throw std::system_error(make_error_code(std::errc::broken_pipe), "utils::stream::ofstream: put to a closed stream");
+		if(output->direct() || chunk.size() < threshold)
+			return append(chunk.data(), chunk.size());
+		auto keeper = std::make_shared<utils::buffer::owner<const std::byte>>(std::move(chunk));
+		gather(keeper->data(), keeper->size(), keeper);
+	}
+
+	void ofstream::flush()
+	{
+		if(!output)
+			return;
+		if(output->direct())
+			drain_direct(false);
+		else
+			drain();
+	}
+
+	void ofstream::close()
+	{
+		if(!output)
+			return;
+		if(output->direct())
+			drain_direct(true);
+		else
+			drain();
+		output.reset();
+	}
+
+	bool ofstream::closed() const noexcept
+	{
+		return !output;
+	}
+
+	bool ofstream::direct() const noexcept
+	{
+		return output && output->direct();
+	}
+}
@@ -1,22 +1,102 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <vector>
 #include <utils/stream/istream.hpp>
+#include <utils/stream/ostream.hpp>
 #include <filesystem>
 
 namespace utils::stream {
 
+	struct ifstream_options
+	{
+		enum class access { normal, sequential, random };
+		access advice = access::normal;
+		bool willneed = false;
+		bool populate = false;
+		bool huge_pages = false;
+		bool drop_behind = false;
+		std::size_t chunk_size = 4u * 1024u * 1024u;
+	};
+
 	class ifstream: public istream<std::byte>
 	{
+		class mapping;
+		std::shared_ptr<mapping> file;
 		buffer::owner<const std::byte> mmap;
+		ifstream_options options;
 	public:
-		ifstream(const std::filesystem::path& path);
+		ifstream(const std::filesystem::path& path, const ifstream_options& options = {});
 	public:
 		using value_type = utils::buffer::owner<const std::byte>;
 		void get(utils::buffer::view<std::byte>&) override;
 		utils::buffer::owner<const std::byte> get() override;
+		utils::buffer::owner<const std::byte> get(std::size_t size);
+		void close() override;
+		bool closed() const noexcept override;
+	};
+
+	struct ofstream_options
+	{
+		bool append = false;
+		bool direct = false;
+		std::size_t buffer_size = 1024u * 1024u;
+		std::size_t gather_threshold = 64u * 1024u;
+	};
+
+	class ofstream: public ostream<std::byte>
+	{
+		class file;
+		struct aligned_delete
+		{
+			std::size_t alignment;
+			void operator()(std::byte* data) const noexcept;
+		};
+		struct segment
+		{
+			const std::byte* data;
+			std::size_t size;
+		};
+		std::unique_ptr<file> output;
+		std::unique_ptr<std::byte, aligned_delete> memory;
+		std::size_t capacity = 0;
+		std::size_t used = 0;
+		std::vector<segment> pending;
+		std::vector<std::shared_ptr<const void>> retained;
+		std::size_t pending_size = 0;
+		std::size_t threshold = 0;
+		std::uint64_t written = 0;
+		std::uint64_t calls = 0;
+	private:
+		void append(const std::byte* data, std::size_t size);
+		void gather(const std::byte* data, std::size_t size, std::shared_ptr<const void> keeper);
+		void drain();
+		void drain_direct(bool last);
+	public:
+		ofstream(const std::filesystem::path& path, const ofstream_options& options = {});
+		ofstream(ofstream&&) noexcept;
+		ofstream& operator=(ofstream&&) noexcept;
+		~ofstream() override;
+	public:
+		using value_type = utils::buffer::owner<std::byte>;
+		void put(utils::buffer::view<const std::byte>&) override;
+		void put(utils::buffer::owner<std::byte>) override;
+		void put(utils::buffer::owner<const std::byte>);
+		void flush();
 		void close() override;
 		bool closed() const noexcept override;
+	public:
+		bool direct() const noexcept;
+		std::uint64_t bytes_written() const noexcept
+		{
+			return written;
+		}
+		std::uint64_t syscalls() const noexcept
+		{
+			return calls;
+		}
 	};
 
-}
\ No newline at end of file
+}
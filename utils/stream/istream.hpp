@@ -8,7 +8,11 @@ namespace utils::stream {
 	class istream: public utils::channel::ichannel<utils::buffer::owner<const T>>
 	{
 	public:
+		using utils::channel::ichannel<utils::buffer::owner<const T>>::get;
 		virtual void get(utils::buffer::view<T>&) = 0;
+		// Wakes a get() blocked on another thread, after which the stream ends
+		// early. Streams that never block for long have nothing to do.
+		virtual void interrupt() noexcept {}
 		virtual ~istream() = default;
 	public:
 	};
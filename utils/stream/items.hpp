@@ -1,7 +1,8 @@
 #pragma once
-#include <memory>
-#include <vector>
-#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
 #include <utils/channel/ichannel.hpp>
 #include <utils/buffer.hpp>
 
@@ -10,31 +11,91 @@ namespace utils {
 	class items
 	{
 		using Buffer = typename IChannel::value_type;
-		struct Record
+		using pointer_t = decltype(std::declval<const Buffer&>().data());
+		struct Chunk
 		{
 			Buffer buffer;
-			std::shared_ptr<Record> next;
+			std::size_t users = 0;
 		public:
-			Record(Buffer buffer, std::shared_ptr<Record> next) noexcept
+			Chunk(Buffer buffer) noexcept
 			: buffer(std::move(buffer))
-			, next(std::move(next))
 			{}
 		};
 		IChannel ichannel;
+		std::deque<Chunk> chunks;
+		std::uint64_t first = 0;
+	private:
+		bool load(std::uint64_t sequence)
+		{
+			while(sequence - first >= chunks.size()) {
+				if(!ichannel.closed())
+					return false;
+				chunks.emplace_back(ichannel.get());
+			}
+			return true;
+		}
+		Chunk& chunk(std::uint64_t sequence) noexcept
+		{
+			return chunks[sequence - first];
+		}
+		void acquire(std::uint64_t sequence) noexcept
+		{
+			++chunk(sequence).users;
+		}
+		void release(std::uint64_t sequence) noexcept
+		{
+			--chunk(sequence).users;
+			while(!chunks.empty() && !chunks.front().users) {
+				chunks.pop_front();
+				++first;
+			}
+		}
 	public:
 		items(IChannel&& ichannel) noexcept
 		: ichannel(std::move(ichannel))
 		{}
-		items(items&&) = default;
-		items(const items&) = default;
-		items& operator=(const items&) = default;
-		items& operator=(items&&) = default;
+		// Iterators point back at the ring, so it stays where it was built.
+		items(items&&) = delete;
+		items(const items&) = delete;
+		items& operator=(const items&) = delete;
+		items& operator=(items&&) = delete;
 	public:
 		class iterator
 		{
-			IChannel* ichannel = nullptr;
-			std::shared_ptr<Record> record;
-			std::size_t index = 0;
+			friend class items;
+			items* owner = nullptr;
+			pointer_t it = nullptr;
+			pointer_t last = nullptr;
+			std::uint64_t sequence = 0;
+		private:
+			iterator(items& owner, std::uint64_t sequence)
+			: owner(&owner)
+			, sequence(sequence)
+			{
+				seek();
+			}
+			void seek()
+			{
+				for(; owner->load(sequence); ++sequence) {
+					auto& chunk = owner->chunk(sequence);
+					if(chunk.buffer.size()) {
+						++chunk.users;
+						it = chunk.buffer.data();
+						last = it + chunk.buffer.size();
+						return;
+					}
+				}
+				owner = nullptr;
+				it = last = nullptr;
+				sequence = 0;
+			}
+			void next()
+			{
+				const auto previous = sequence++;
+				auto* ring = owner;
+				seek();
+				ring->release(previous);
+			}
 		public:
 			using iterator_category = std::forward_iterator_tag;
 			using difference_type   = std::ptrdiff_t;
@@ -43,69 +104,113 @@ namespace utils {
 			using reference         = std::remove_reference_t<value_type>&;
 		public:
 			iterator() = default;
-			iterator(IChannel& ichannel, std::shared_ptr<Record> record) noexcept
-			: ichannel(&ichannel)
-			, record(std::move(record))
-			{}
 			iterator(const iterator& other) noexcept
-			: ichannel(other.ichannel)
-			, record(other.record)
-			, index(other.index)
-			{}
+			: owner(other.owner)
+			, it(other.it)
+			, last(other.last)
+			, sequence(other.sequence)
+			{
+				if(owner)
+					owner->acquire(sequence);
+			}
+			iterator(iterator&& other) noexcept
+			: owner(other.owner)
+			, it(other.it)
+			, last(other.last)
+			, sequence(other.sequence)
+			{
+				other.owner = nullptr;
+				other.it = other.last = nullptr;
+				other.sequence = 0;
+			}
 			iterator& operator=(const iterator& other) noexcept
 			{
 				if(this != &other) {
-					ichannel = other.ichannel;
-					record = other.record;
-					index = other.index;
+					iterator copy(other);
+					*this = std::move(copy);
 				}
 				return *this;
 			}
+			iterator& operator=(iterator&& other) noexcept
+			{
+				if(this != &other) {
+					if(owner)
+						owner->release(sequence);
+					owner = other.owner;
+					it = other.it;
+					last = other.last;
+					sequence = other.sequence;
+					other.owner = nullptr;
+					other.it = other.last = nullptr;
+					other.sequence = 0;
+				}
+				return *this;
+			}
+			~iterator()
+			{
+				if(owner)
+					owner->release(sequence);
+			}
+		public:
 			decltype(auto) operator*() const
 			{
-				return record->buffer[index];
+				return *it;
 			}
 			iterator& operator++()
 			{
-				if(++index == record->buffer.size()) {
-					if(!record->next) {
-						if(!ichannel->closed())
-							record->next = std::make_shared<Record>(ichannel->get(), nullptr);
-						else
-							ichannel = nullptr;
-					}
-					record = record->next;
-					index = 0;
-				}
+				if(++it == last)
+					next();
 				return *this;
 			}
 			iterator operator++(int)
 			{
+				iterator result(*this);
 				++(*this);
-				return iiterator(*this);
+				return result;
+			}
+			auto segment() const noexcept
+			{
+				return buffer::view<std::remove_pointer_t<pointer_t>>(it, last - it);
+			}
+			iterator& advance(std::size_t count)
+			{
+				if(count < static_cast<std::size_t>(last - it)) {
+					it += count;
+					return *this;
+				}
+				while(count && owner) {
+					const auto step = std::min<std::size_t>(count, last - it);
+					it += step;
+					count -= step;
+					if(it == last)
+						next();
+				}
+				return *this;
 			}
 			friend bool operator==(const iterator& a, const iterator& b) noexcept
 			{
-				return a.ichannel == b.ichannel && a.index == b.index && a.record == b.record;
+				return a.it == b.it && a.sequence == b.sequence;
 			}
 			friend bool operator!=(const iterator& a, const iterator& b) noexcept
 			{
-				return a.ichannel != b.ichannel || a.index != b.index || a.record != b.record;
+				return !(a == b);
 			}
 		};
 	public:
 		auto begin()
 		{
-			if(ichannel)
-				return iterator(ichannel, std::make_shared<Record>(ichannel.get(), nullptr));
-			return iterator();
+			return iterator(*this, first);
 		}
 		auto end() const noexcept
 		{
 			return iterator();
 		}
+		std::size_t retained() const noexcept
+		{
+			return chunks.size();
+		}
 	};
 
 	template<class Channel>
 	items(Channel&& ichannel) -> items<std::remove_cv_t<std::remove_reference_t<Channel>>>;
-}
\ No newline at end of file
+}
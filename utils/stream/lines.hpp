@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utils/buffer.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	define UTILS_STREAM_SSE2 1
+#	include <emmintrin.h>
+#	if defined(__GNUC__) || defined(__clang__)
+#		define UTILS_STREAM_AVX2 1
+#		include <immintrin.h>
+#	endif
+#endif
+
+namespace utils::stream {
+
+	struct line_column
+	{
+		std::uint64_t line = 1;
+		std::uint64_t column = 1;
+	public:
+		friend bool operator==(const line_column& a, const line_column& b) noexcept
+		{
+			return a.line == b.line && a.column == b.column;
+		}
+		friend bool operator!=(const line_column& a, const line_column& b) noexcept
+		{
+			return !(a == b);
+		}
+	};
+
+	class line_index
+	{
+		struct chunk
+		{
+			std::uint64_t offset;
+			std::uint64_t line;
+			std::uint64_t start;
+			std::vector<std::uint32_t> newlines;
+		};
+		std::vector<chunk> chunks;
+		std::uint64_t length = 0;
+		std::uint64_t lines = 0;
+		std::uint64_t start = 0;
+	public:
+		enum class kernel { scalar, sse2, avx2 };
+		static constexpr std::size_t max_chunk = std::size_t(1) << 31;
+	public:
+		static void scalar(const std::uint8_t* begin, const std::uint8_t* end, std::vector<std::uint32_t>& newlines)
+		{
+			for(auto it = begin; it != end; ++it)
+				if(*it == '\n')
+					newlines.push_back(static_cast<std::uint32_t>(it - begin));
+		}
+#if defined(UTILS_STREAM_SSE2)
+		static void sse2(const std::uint8_t* begin, const std::uint8_t* end, std::vector<std::uint32_t>& newlines)
+		{
+			const auto newline = _mm_set1_epi8('\n');
+			auto it = begin;
+			for(; end - it >= 16; it += 16) {
+				auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)), newline)));
+				for(; mask; mask &= mask - 1)
+					newlines.push_back(static_cast<std::uint32_t>(it - begin + __builtin_ctz(mask)));
+			}
+			const auto first = newlines.size();
+			scalar(it, end, newlines);
+			for(auto i = first; i < newlines.size(); ++i)
+				newlines[i] += static_cast<std::uint32_t>(it - begin);
+		}
+#endif
+#if defined(UTILS_STREAM_AVX2)
+		__attribute__((target("avx2")))
+		static void avx2(const std::uint8_t* begin, const std::uint8_t* end, std::vector<std::uint32_t>& newlines)
+		{
+			const auto newline = _mm256_set1_epi8('\n');
+			auto it = begin;
+			for(; end - it >= 64; it += 64) {
+				const auto low = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)), newline)));
+				const auto high = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 32)), newline)));
+				auto mask = static_cast<std::uint64_t>(high) << 32 | low;
+				for(; mask; mask &= mask - 1)
+					newlines.push_back(static_cast<std::uint32_t>(it - begin + __builtin_ctzll(mask)));
+			}
+			const auto first = newlines.size();
+			sse2(it, end, newlines);
+			for(auto i = first; i < newlines.size(); ++i)
+				newlines[i] += static_cast<std::uint32_t>(it - begin);
+		}
+#endif
+		static kernel best() noexcept
+		{
+#if defined(UTILS_STREAM_AVX2)
+			static const bool avx2 = __builtin_cpu_supports("avx2");
+			if(avx2)
+				return kernel::avx2;
+#endif
+#if defined(UTILS_STREAM_SSE2)
+			return kernel::sse2;
+#else
+			return kernel::scalar;
+#endif
+		}
+		static void run(kernel type, const std::uint8_t* begin, const std::uint8_t* end, std::vector<std::uint32_t>& newlines)
+		{
+			switch(type) {
+#if defined(UTILS_STREAM_AVX2)
+				case kernel::avx2: return avx2(begin, end, newlines);
+#endif
+#if defined(UTILS_STREAM_SSE2)
+				case kernel::sse2: return sse2(begin, end, newlines);
+#endif
+				default: return scalar(begin, end, newlines);
+			}
+		}
+	public:
+		void add(buffer::view<const std::byte> data)
+		{
+			static const auto type = best();
+			while(!data.empty()) {
+				const auto part = data.first(max_chunk);
+				auto& entry = chunks.emplace_back(chunk{length, lines, start, {}});
+				const auto* first = reinterpret_cast<const std::uint8_t*>(part.data());
+				run(type, first, first + part.size(), entry.newlines);
+				length += part.size();
+				lines += entry.newlines.size();
+				if(!entry.newlines.empty())
+					start = entry.offset + entry.newlines.back() + 1;
+			}
+		}
+		line_column position(std::uint64_t offset) const noexcept
+		{
+			const auto found = std::upper_bound(chunks.begin(), chunks.end(), offset, [](std::uint64_t offset, const chunk& entry) {
+				return offset < entry.offset;
+			});
+			if(found == chunks.begin())
+				return {1, offset + 1};
+			const auto& entry = *(found - 1);
+			const auto relative = offset - entry.offset;
+			const auto before = static_cast<std::size_t>(std::lower_bound(entry.newlines.begin(), entry.newlines.end(), relative) - entry.newlines.begin());
+			const auto line_start = before ? entry.offset + entry.newlines[before - 1] + 1 : entry.start;
+			return {entry.line + before + 1, offset - line_start + 1};
+		}
+		std::uint64_t size() const noexcept
+		{
+			return length;
+		}
+		std::uint64_t line_count() const noexcept
+		{
+			return lines + 1;
+		}
+	};
+
+	template<class IChannel>
+	class line_indexer
+	{
+		IChannel channel;
+		line_index index;
+	public:
+		template<class Channel>
+		explicit line_indexer(Channel&& channel)
+		: channel(std::forward<Channel>(channel))
+		{}
+	public:
+		using value_type = typename IChannel::value_type;
+		value_type get()
+		{
+			auto chunk = channel.get();
+			index.add(chunk);
+			return chunk;
+		}
+		bool closed() const noexcept
+		{
+			return channel.closed();
+		}
+		void close()
+		{
+			channel.close();
+		}
+		const line_index& lines() const noexcept
+		{
+			return index;
+		}
+		line_column position(std::uint64_t offset) const noexcept
+		{
+			return index.position(offset);
+		}
+	};
+
+	template<class Channel>
+	line_indexer(Channel&& channel) -> line_indexer<std::remove_cv_t<std::remove_reference_t<Channel>>>;
+}
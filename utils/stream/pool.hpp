@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <utils/buffer.hpp>
+
+namespace utils::stream {
+
+	class buffer_pool
+	{
+		struct state
+		{
+			std::mutex mutex;
+			std::vector<std::unique_ptr<std::byte[]>> free;
+			std::size_t size;
+			std::size_t keep;
+		public:
+			state(std::size_t size, std::size_t keep)
+			: size(size), keep(keep)
+			{}
+		};
+
+		class chunk: public buffer::Resource<const std::byte>
+		{
+			std::shared_ptr<state> pool;
+			std::unique_ptr<std::byte[]> memory;
+			std::size_t size;
+		public:
+			chunk(std::shared_ptr<state> pool, std::unique_ptr<std::byte[]> memory, std::size_t size) noexcept
+			: pool(std::move(pool)), memory(std::move(memory)), size(size)
+			{}
+			~chunk() override
+			{
+				std::lock_guard lock(pool->mutex);
+				if(pool->free.size() < pool->keep)
+					pool->free.push_back(std::move(memory));
+			}
+		public:
+			const std::byte* begin() const noexcept override
+			{
+				return memory.get();
+			}
+			const std::byte* end() const noexcept override
+			{
+				return memory.get() + size;
+			}
+		};
+
+		std::shared_ptr<state> shared;
+	public:
+		class slot
+		{
+			buffer::owner<const std::byte> handle;
+			std::byte* memory;
+		public:
+			slot(buffer::owner<const std::byte> handle, std::byte* memory) noexcept
+			: handle(std::move(handle)), memory(memory)
+			{}
+			slot(slot&&) = default;
+			slot& operator=(slot&&) = default;
+		public:
+			std::byte* data() noexcept
+			{
+				return memory;
+			}
+			std::size_t capacity() const noexcept
+			{
+				return handle.size();
+			}
+			buffer::owner<const std::byte> seal(std::size_t filled) &&
+			{
+				return handle.first(filled);
+			}
+		};
+	public:
+		buffer_pool(std::size_t size, std::size_t keep)
+		: shared(std::make_shared<state>(size, keep))
+		{
+			shared->free.reserve(keep);
+		}
+	public:
+		std::size_t buffer_size() const noexcept
+		{
+			return shared->size;
+		}
+		std::size_t available() const
+		{
+			std::lock_guard lock(shared->mutex);
+			return shared->free.size();
+		}
+		slot acquire()
+		{
+			std::unique_ptr<std::byte[]> memory;
+			{
+				std::lock_guard lock(shared->mutex);
+				if(!shared->free.empty()) {
+					memory = std::move(shared->free.back());
+					shared->free.pop_back();
+				}
+			}
+			if(!memory)
+				memory.reset(new std::byte[shared->size]);
+			auto* data = memory.get();
+			return slot(buffer::make<chunk>(shared, std::move(memory), shared->size), data);
+		}
+	};
+
+}
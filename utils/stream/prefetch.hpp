@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <utils/stream/pool.hpp>
+
+namespace utils::stream {
+
+	class prefetcher
+	{
+	public:
+		using fill_t = std::function<std::size_t(std::byte*, std::size_t)>;
+		using interrupt_t = std::function<void()>;
+	private:
+		buffer_pool pool;
+		const std::size_t depth;
+		fill_t fill;
+		interrupt_t interrupt;
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::deque<buffer::owner<const std::byte>> ready;
+		std::exception_ptr error;
+		bool finished = false;
+		bool stopping = false;
+		std::thread thread;
+	private:
+		void run() noexcept
+		{
+			try {
+				for(;;) {
+					auto slot = pool.acquire();
+					const auto filled = fill(slot.data(), slot.capacity());
+					if(!filled)
+						break;
+					auto chunk = std::move(slot).seal(filled);
+					std::unique_lock lock(mutex);
+					changed.wait(lock, [this] { return stopping || ready.size() < depth; });
+					if(stopping)
+						break;
+					ready.push_back(std::move(chunk));
+					changed.notify_all();
+				}
+			} catch(...) {
+				std::lock_guard lock(mutex);
+				error = std::current_exception();
+			}
+			std::lock_guard lock(mutex);
+			finished = true;
+			changed.notify_all();
+		}
+	public:
+		prefetcher(std::size_t chunk_size, std::size_t depth, fill_t fill, interrupt_t interrupt = {})
+		: pool(chunk_size, depth + 1)
+		, depth(std::max<std::size_t>(depth, 1))
+		, fill(std::move(fill))
+		, interrupt(std::move(interrupt))
+		, thread(&prefetcher::run, this)
+		{}
+		prefetcher(const prefetcher&) = delete;
+		prefetcher& operator=(const prefetcher&) = delete;
+		~prefetcher()
+		{
+			stop();
+			thread.join();
+		}
+	public:
+		// The chunks already read are still handed out, then next() ends.
+		void stop() noexcept
+		{
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+				changed.notify_all();
+			}
+			if(interrupt)
+				interrupt();
+		}
+		buffer::owner<const std::byte> next()
+		{
+			std::unique_lock lock(mutex);
+			changed.wait(lock, [this] { return !ready.empty() || finished; });
+			if(ready.empty()) {
+				if(error)
+					std::rethrow_exception(std::exchange(error, nullptr));
+				return {};
+			}
+			auto chunk = std::move(ready.front());
+			ready.pop_front();
+			changed.notify_all();
+			return chunk;
+		}
+	};
+
+}
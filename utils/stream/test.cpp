@@ -1,9 +1,24 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <condition_variable>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+#include <utils/stream/fdstream.hpp>
+#include <utils/stream/chunked.hpp>
 #include <utils/stream/fstream.hpp>
 #include <utils/stream/items.hpp>
+#include <utils/stream/lines.hpp>
+#include <utils/stream/zstream.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 
 namespace fs = std::filesystem;
 
@@ -14,6 +29,7 @@ void TouchFile(const fs::path& path, const std::string& value)
 }
 
 using items_ifstream_iterator = typename utils::items<utils::stream::ifstream>::iterator;
+static_assert(!std::is_move_constructible_v<utils::items<utils::stream::ifstream>>);
 
 TEST_CASE("test file stream", "[utils], [stream]")
 {
@@ -25,6 +41,47 @@ TEST_CASE("test file stream", "[utils], [stream]")
 	REQUIRE(value == "hello from file"_bytes);
 }
 
+TEST_CASE("test file stream options", "[utils], [stream]")
+{
+	using utils::operator""_bytes;
+	const fs::path path = "fstream-test.data";
+	TouchFile(path, "hello from file");
+	utils::stream::ifstream_options options;
+	options.chunk_size = 5;
+	options.advice = utils::stream::ifstream_options::access::sequential;
+	options.willneed = true;
+	utils::stream::ifstream file(path, options);
+	REQUIRE(file.get() == "hello"_bytes);
+	REQUIRE(file.get() == " from"_bytes);
+	REQUIRE(file.get() == " file"_bytes);
+	REQUIRE(!file.closed());
+
+	const fs::path large = "fstream-test-large.data";
+	std::string content;
+	for(std::size_t i = 0; content.size() < 5 * 4096 + 17; ++i)
+		content += std::to_string(i) + ' ';
+	std::ofstream(large, std::ios::binary | std::ios::trunc) << content;
+	options = {};
+	options.chunk_size = 4096;
+	options.populate = true;
+	options.huge_pages = true;
+	options.drop_behind = true;
+	std::string read;
+	std::size_t chunks = 0;
+	for(utils::stream::ifstream file(large, options); file.closed(); ++chunks) {
+		const auto chunk = file.get();
+		read.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+	}
+	REQUIRE(read == content);
+	REQUIRE(chunks >= 2);
+
+	const fs::path empty = "fstream-test-empty.data";
+	std::ofstream(empty, std::ios::trunc);
+	utils::stream::ifstream nothing(empty, options);
+	REQUIRE(!nothing.closed());
+	REQUIRE_THROWS_AS(utils::stream::ifstream("fstream-test-missing.data"), std::system_error);
+}
+
 TEST_CASE("test stream items with copy", "[utils], [stream]")
 {
 	using utils::operator""_bytes;
@@ -65,3 +122,412 @@ TEST_CASE("test file stream with items", "[utils], [stream]")
 	const auto str = "hello from file"_bytes;
 	//REQUIRE(std::equal(fchannel.begin(), fchannel.end(), str.begin(), str.end()));
 }
+
+TEST_CASE("test stream items reclaim consumed chunks", "[utils], [stream]")
+{
+	const std::string text = "the quick brown fox jumps over the lazy dog";
+	utils::items chunks = utils::stream::chunked(text, 4);
+	std::string result;
+	std::size_t retained = 0;
+	for(auto it = chunks.begin(); it != chunks.end(); ++it) {
+		result += static_cast<char>(*it);
+		retained = std::max(retained, chunks.retained());
+	}
+	REQUIRE(result == text);
+	REQUIRE(retained == 1);
+	REQUIRE(chunks.retained() == 0);
+	REQUIRE(chunks.begin() == chunks.end());
+}
+
+TEST_CASE("test stream items keep the lookahead window", "[utils], [stream]")
+{
+	const std::string text = "0123456789abcdefghij";
+	utils::items chunks = utils::stream::chunked(text, 3);
+	auto mark = chunks.begin();
+	auto it = mark;
+	for(int i = 0; i < 10; ++i)
+		++it;
+	REQUIRE(static_cast<char>(*it) == 'a');
+	REQUIRE(chunks.retained() == 4);
+	REQUIRE(static_cast<char>(*mark) == '0');
+	mark = it;
+	REQUIRE(chunks.retained() == 1);
+	auto copy = it++;
+	REQUIRE(static_cast<char>(*copy) == 'a');
+	REQUIRE(static_cast<char>(*it) == 'b');
+	REQUIRE(std::distance(it, chunks.end()) == 9);
+	REQUIRE(chunks.retained() == 4);
+	copy = chunks.end();
+	mark = chunks.end();
+	it = chunks.end();
+	REQUIRE(chunks.retained() == 0);
+}
+
+namespace {
+
+	template<class Stream>
+	std::string drain(Stream& stream, std::size_t& chunks)
+	{
+		static_assert(std::is_base_of_v<utils::stream::istream<std::byte>, Stream>);
+		std::string result;
+		for(chunks = 0; stream.closed(); ++chunks) {
+			const auto chunk = stream.get();
+			result.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+		}
+		return result;
+	}
+}
+
+TEST_CASE("test fd stream reads files", "[utils], [stream]")
+{
+	const fs::path path = "fdstream-test.data";
+	std::string content;
+	for(std::size_t i = 0; content.size() < 3 * 4096 + 7; ++i)
+		content += std::to_string(i) + ' ';
+	std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+	std::vector<utils::stream::fdstream_options::engine> engines = {utils::stream::fdstream_options::engine::automatic, utils::stream::fdstream_options::engine::read};
+	if(utils::stream::fdstream::io_uring_supported())
+		engines.push_back(utils::stream::fdstream_options::engine::io_uring);
+	for(const auto engine: engines) {
+		utils::stream::fdstream_options options;
+		options.backend = engine;
+		options.chunk_size = 4096;
+		options.depth = 3;
+		utils::stream::fdstream file(path, options);
+		std::size_t chunks = 0;
+		REQUIRE(drain(file, chunks) == content);
+		REQUIRE(chunks == 4);
+		REQUIRE(!file.closed());
+	}
+
+	utils::stream::fdstream file(path);
+	std::byte buffer[10];
+	utils::buffer::view<std::byte> view(buffer);
+	file.get(view);
+	REQUIRE(view == utils::buffer::view<const std::byte>(reinterpret_cast<const std::byte*>(content.data()), 10));
+
+	std::ofstream("fdstream-test-empty.data", std::ios::trunc);
+	REQUIRE(!utils::stream::fdstream(fs::path("fdstream-test-empty.data")).closed());
+	REQUIRE_THROWS_AS(utils::stream::fdstream(fs::path("fdstream-test-missing.data")), std::system_error);
+}
+
+TEST_CASE("test fd stream reads pipes and proc files", "[utils], [stream]")
+{
+	int fds[2];
+	REQUIRE(::pipe(fds) == 0);
+	std::string content;
+	for(std::size_t i = 0; content.size() < 100000; ++i)
+		content += std::to_string(i) + '\n';
+	std::thread writer([&] {
+		for(std::size_t offset = 0; offset < content.size(); ) {
+			const auto count = ::write(fds[1], content.data() + offset, std::min<std::size_t>(777, content.size() - offset));
+			if(count > 0)
+				offset += static_cast<std::size_t>(count);
+		}
+		::close(fds[1]);
+	});
+	utils::stream::fdstream_options options;
+	options.chunk_size = 8192;
+	utils::stream::fdstream pipe(fds[0], options, true);
+	REQUIRE(pipe.engine() == utils::stream::fdstream_options::engine::read);
+	std::size_t chunks = 0;
+	REQUIRE(drain(pipe, chunks) == content);
+	REQUIRE(chunks >= content.size() / 8192);
+	writer.join();
+
+	int idle[2];
+	REQUIRE(::pipe(idle) == 0);
+	{
+		utils::stream::fdstream stalled(idle[0], options);
+	}
+	::close(idle[0]);
+	::close(idle[1]);
+
+	utils::stream::fdstream status(fs::path("/proc/self/status"));
+	const auto text = drain(status, chunks);
+	REQUIRE(text.find("Name:") != std::string::npos);
+}
+
+TEST_CASE("test file output stream", "[utils], [stream]")
+{
+	using utils::operator""_bytes;
+	const fs::path path = "ofstream-test.data";
+	std::string expected;
+	for(const bool direct: {false, true}) {
+		expected.clear();
+		utils::stream::ofstream_options options;
+		options.buffer_size = 4096;
+		options.gather_threshold = 1024;
+		options.direct = direct;
+		utils::stream::ofstream file(path, options);
+		for(int i = 0; i < 1000; ++i) {
+			const auto line = std::to_string(i) + '\n';
+			utils::buffer::view<const std::byte> view(reinterpret_cast<const std::byte*>(line.data()), line.size());
+			file.put(view);
+			expected += line;
+			if(i % 100 == 0) {
+				const std::string block(3000, static_cast<char>('a' + i / 100));
+				file.put(utils::buffer::owner<const std::byte>(std::vector<std::byte>(reinterpret_cast<const std::byte*>(block.data()), reinterpret_cast<const std::byte*>(block.data() + block.size()))));
+				expected += block;
+			}
+		}
+		REQUIRE(!file.closed());
+		file.close();
+		REQUIRE(file.closed());
+		REQUIRE(file.bytes_written() == expected.size());
+		REQUIRE(file.syscalls() < 1000 / 10);
+		REQUIRE_THROWS_AS(file.put(utils::buffer::owner<std::byte>()), std::system_error);
+		std::ifstream input(path, std::ios::binary);
+		const std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		REQUIRE(content == expected);
+	}
+
+	{
+		utils::stream::ofstream_options options;
+		options.append = true;
+		utils::stream::ofstream file(path, options);
+		auto tail = "tail"_bytes;
+		file.put(tail);
+	}
+	expected += "tail";
+	std::ifstream input(path, std::ios::binary);
+	const std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	REQUIRE(content == expected);
+
+	for(const bool aligned: {false, true}) {
+		if(aligned) {
+			expected.assign(8192, 'x');
+			std::ofstream(path, std::ios::binary | std::ios::trunc) << expected;
+		}
+		const std::string more(10000, aligned ? 'y' : 'z');
+		{
+			utils::stream::ofstream_options options;
+			options.buffer_size = 4096;
+			options.append = true;
+			options.direct = true;
+			utils::stream::ofstream file(path, options);
+			if(!aligned)
+				REQUIRE(!file.direct());
+			file.put(utils::buffer::owner<const std::byte>(std::vector<std::byte>(reinterpret_cast<const std::byte*>(more.data()), reinterpret_cast<const std::byte*>(more.data() + more.size()))));
+		}
+		expected += more;
+		std::ifstream appended(path, std::ios::binary);
+		REQUIRE(std::string((std::istreambuf_iterator<char>(appended)), std::istreambuf_iterator<char>()) == expected);
+	}
+}
+
+namespace {
+
+	template<class Compressor>
+	void compress(const fs::path& path, const std::string& content, Compressor compressor)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		boost::iostreams::filtering_ostream output;
+		output.push(compressor);
+		output.push(file);
+		output << content;
+	}
+}
+
+TEST_CASE("test decompressing streams", "[utils], [stream]")
+{
+	using format = utils::stream::zstream_options::format;
+	std::string content;
+	for(std::size_t i = 0; content.size() < 200000; ++i)
+		content += "local value_" + std::to_string(i) + " = " + std::to_string(i * 7) + "\n";
+	compress("zstream-test.gz", content, boost::iostreams::gzip_compressor());
+	compress("zstream-test.zz", content, boost::iostreams::zlib_compressor());
+	std::ofstream("zstream-test.txt", std::ios::binary | std::ios::trunc) << content;
+	std::ofstream("zstream-test.lua", std::ios::binary | std::ios::trunc) << "x = 1\nprint(x)\n";
+
+	for(const bool pipelined: {false, true}) {
+		utils::stream::zstream_options options;
+		options.chunk_size = 16384;
+		options.pipelined = pipelined;
+		std::size_t chunks = 0;
+		utils::stream::zstream gzip(fs::path("zstream-test.gz"), options);
+		REQUIRE(gzip.format() == format::gzip);
+		REQUIRE(drain(gzip, chunks) == content);
+		REQUIRE(chunks == (content.size() + options.chunk_size - 1) / options.chunk_size);
+		utils::stream::zstream plain(fs::path("zstream-test.txt"), options);
+		REQUIRE(plain.format() == format::none);
+		REQUIRE(drain(plain, chunks) == content);
+		utils::stream::zstream script(fs::path("zstream-test.lua"), options);
+		REQUIRE(script.format() == format::none);
+		REQUIRE(drain(script, chunks) == "x = 1\nprint(x)\n");
+		utils::stream::zstream undetected(fs::path("zstream-test.zz"), options);
+		REQUIRE(undetected.format() == format::none);
+		options.compression = format::zlib;
+		utils::stream::zstream zlib(utils::stream::fdstream(fs::path("zstream-test.zz")), options);
+		REQUIRE(zlib.format() == format::zlib);
+		REQUIRE(drain(zlib, chunks) == content);
+	}
+
+	utils::stream::zstream_options options;
+	options.compression = format::gzip;
+	std::ofstream("zstream-test.bad", std::ios::binary | std::ios::trunc) << "\x1f\x8b garbage that is not deflate";
+	utils::stream::zstream broken(fs::path("zstream-test.bad"), options);
+	REQUIRE(broken.closed());
+	REQUIRE_THROWS_AS(broken.get(), std::system_error);
+
+	options.compression = format::zstd;
+	if(!utils::stream::zstream::zstd_supported())
+		REQUIRE_THROWS_AS(utils::stream::zstream(fs::path("zstream-test.txt"), options), std::system_error);
+
+	int idle[2];
+	REQUIRE(::pipe(idle) == 0);
+	{
+		options.compression = format::none;
+		options.pipelined = true;
+		utils::stream::zstream stalled(utils::stream::fdstream(idle[0]), options);
+	}
+	::close(idle[0]);
+	::close(idle[1]);
+}
+
+namespace {
+
+	struct counted: utils::buffer::Resource<const std::byte>
+	{
+		std::vector<std::byte> bytes;
+		int& alive;
+	public:
+		counted(std::size_t size, int& alive)
+		: bytes(size, std::byte('x')), alive(alive)
+		{
+			++alive;
+		}
+		~counted() override
+		{
+			--alive;
+		}
+	public:
+		const std::byte* begin() const noexcept override
+		{
+			return bytes.data();
+		}
+		const std::byte* end() const noexcept override
+		{
+			return bytes.data() + bytes.size();
+		}
+	};
+}
+
+TEST_CASE("test buffer owner resources", "[utils], [stream]")
+{
+	using utils::operator""_bytes;
+	using owner = utils::buffer::owner<const std::byte>;
+
+	owner small(std::vector<std::byte>(reinterpret_cast<const std::byte*>("local x"), reinterpret_cast<const std::byte*>("local x") + 7));
+	REQUIRE(small.embedded());
+	owner moved(std::move(small));
+	REQUIRE(moved.embedded());
+	REQUIRE(small.empty());
+	REQUIRE(moved == "local x"_bytes);
+	auto head = moved.first(5);
+	REQUIRE(head == "local"_bytes);
+	REQUIRE(moved == " x"_bytes);
+	REQUIRE(owner::copy(reinterpret_cast<const std::byte*>("a somewhat longer payload string"), 32).embedded() == false);
+
+	int alive = 0;
+	for(const bool local: {false, true}) {
+		{
+			owner whole = local ? utils::buffer::make_local<counted>(100, alive) : utils::buffer::make<counted>(100, alive);
+			REQUIRE(alive == 1);
+			REQUIRE(!whole.embedded());
+			auto part = whole.slice(10, 20);
+			whole = owner();
+			REQUIRE(alive == 1);
+			REQUIRE(part.size() == 20);
+			auto shared = part.share();
+			part = owner();
+			REQUIRE(alive == 1);
+			REQUIRE(shared.size() == 20);
+		}
+		REQUIRE(alive == 0);
+	}
+
+	{
+		using slab = utils::details::pooled<counted>::slab_t;
+		constexpr std::size_t batch = 256;
+		constexpr std::size_t rounds = 100;
+		const std::size_t reserved = slab::reserved();
+		std::vector<owner> handed;
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::thread worker([&] {
+			for(std::size_t i = 0; i < rounds; ++i) {
+				std::unique_lock lock(mutex);
+				ready.wait(lock, [&] { return handed.empty(); });
+				for(std::size_t j = 0; j < batch; ++j)
+					handed.push_back(utils::buffer::make<counted>(16, alive));
+				ready.notify_all();
+			}
+		});
+		for(std::size_t i = 0; i < rounds; ++i) {
+			std::unique_lock lock(mutex);
+			ready.wait(lock, [&] { return !handed.empty(); });
+			handed.clear();
+			ready.notify_all();
+		}
+		worker.join();
+		REQUIRE(alive == 0);
+		REQUIRE(slab::reserved() - reserved <= 4 * batch);
+	}
+
+	{
+		owner adapted(std::make_shared<counted>(50, alive));
+		auto tail = adapted.last(10);
+		adapted = owner();
+		REQUIRE(alive == 1);
+		REQUIRE(tail.size() == 10);
+	}
+	REQUIRE(alive == 0);
+}
+
+TEST_CASE("test newline index", "[utils], [stream]")
+{
+	using kernel = utils::stream::line_index::kernel;
+	std::string text;
+	for(std::size_t i = 0; i < 5000; ++i)
+		text += std::string(i * 7 % 23, 'a' + i % 26) + (i % 5 ? "\n" : "\n\n");
+	const auto* begin = reinterpret_cast<const std::uint8_t*>(text.data());
+	std::vector<std::uint32_t> expected;
+	utils::stream::line_index::run(kernel::scalar, begin, begin + text.size(), expected);
+	std::vector<kernel> kernels = {utils::stream::line_index::best()};
+#if defined(UTILS_STREAM_SSE2)
+	kernels.push_back(kernel::sse2);
+#endif
+#if defined(UTILS_STREAM_AVX2)
+	if(__builtin_cpu_supports("avx2"))
+		kernels.push_back(kernel::avx2);
+#endif
+	for(const auto type: kernels) {
+		std::vector<std::uint32_t> newlines;
+		utils::stream::line_index::run(type, begin + 3, begin + text.size(), newlines);
+		std::vector<std::uint32_t> shifted;
+		for(const auto offset: expected)
+			if(offset >= 3)
+				shifted.push_back(offset - 3);
+		REQUIRE(newlines == shifted);
+	}
+
+	const fs::path path = "lines-test.data";
+	std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+	utils::stream::ifstream_options options;
+	options.chunk_size = 1000;
+	utils::stream::line_indexer file(utils::stream::ifstream(path, options));
+	while(file.closed())
+		file.get();
+	REQUIRE(file.lines().size() == text.size());
+	REQUIRE(file.lines().line_count() == expected.size() + 1);
+	utils::stream::line_column position;
+	for(std::size_t offset = 0; offset < text.size(); ++offset) {
+		REQUIRE(file.position(offset) == position);
+		if(text[offset] == '\n')
+			position = {position.line + 1, 1};
+		else
+			++position.column;
+	}
+	REQUIRE(utils::stream::line_index().position(5) == utils::stream::line_column{1, 6});
+}
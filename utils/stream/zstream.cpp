@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <exception>
+#include <system_error>
+#include <utility>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#if defined(UTILS_STREAM_ZSTD)
+#	include <boost/iostreams/filter/zstd.hpp>
+#endif
+#include <utils/stream/fstream.hpp>
+#include <utils/stream/pool.hpp>
+#include <utils/stream/prefetch.hpp>
+#include "zstream.hpp"
+
+namespace utils::stream {
+
+	class zstream::decoder
+	{
+		struct device
+		{
+			using char_type = char;
+			using category = boost::iostreams::source_tag;
+			decoder* owner;
+		public:
+			std::streamsize read(char* data, std::streamsize size)
+			{
+				return owner->read(reinterpret_cast<std::byte*>(data), static_cast<std::size_t>(size));
+			}
+		};
+		std::unique_ptr<istream<std::byte>> input;
+		buffer::owner<const std::byte> pending;
+		zstream_options::format compression;
+		boost::iostreams::filtering_istreambuf filters;
+		buffer_pool pool;
+	private:
+		bool load()
+		{
+			while(pending.empty()) {
+				if(!input->closed())
+					return false;
+				pending = input->get();
+			}
+			return true;
+		}
+		std::streamsize read(std::byte* data, std::size_t size)
+		{
+			if(!load())
+				return -1;
+			const auto chunk = pending.first(size);
+			std::copy(chunk.begin(), chunk.end(), data);
+			return static_cast<std::streamsize>(chunk.size());
+		}
+		// zlib has no magic: its two header bytes also start plain text such as
+		// "x = 1", so it is only decoded when asked for.
+		zstream_options::format detect()
+		{
+			if(!load())
+				return zstream_options::format::none;
+			const auto magic = [this](std::size_t index) {
+				return index < pending.size() ? std::to_integer<unsigned>(pending[index]) : 0u;
+			};
+			if(magic(0) == 0x1f && magic(1) == 0x8b)
+				return zstream_options::format::gzip;
+			if(magic(0) == 0x28 && magic(1) == 0xb5 && magic(2) == 0x2f && magic(3) == 0xfd)
+				return zstream_options::format::zstd;
+			return zstream_options::format::none;
+		}
+	public:
+		decoder(std::unique_ptr<istream<std::byte>> input, const zstream_options& options)
+		: input(std::move(input))
+		, compression(options.compression)
+		, pool(options.chunk_size, options.depth + 1)
+		{
+			if(compression == zstream_options::format::automatic)
+				compression = detect();
+			switch(compression) {
+				case zstream_options::format::gzip:
+					filters.push(boost::iostreams::gzip_decompressor());
+					break;
+				case zstream_options::format::zlib:
+					filters.push(boost::iostreams::zlib_decompressor());
+					break;
+				case zstream_options::format::zstd:
+#if defined(UTILS_STREAM_ZSTD)
+					filters.push(boost::iostreams::zstd_decompressor());
+					break;
+#else
+					throw std::system_error(make_error_code(std::errc::function_not_supported), "utils::stream::zstream: zstd");
+#endif
+				default:
+					break;
+			}
+			filters.push(device{this});
+		}
+		decoder(const decoder&) = delete;
+		decoder& operator=(const decoder&) = delete;
+	public:
+		zstream_options::format format() const noexcept
+		{
+			return compression;
+		}
+		void interrupt() noexcept
+		{
+			input->interrupt();
+		}
+		std::size_t fill(std::byte* data, std::size_t size)
+		{
+			std::size_t filled = 0;
+			try {
+				while(filled < size) {
+					const auto count = filters.sgetn(reinterpret_cast<char*>(data + filled), static_cast<std::streamsize>(size - filled));
+					if(count <= 0)
+						break;
+					filled += static_cast<std::size_t>(count);
+				}
+			} catch(const std::system_error&) {
+				throw;
+			} catch(const std::exception& e) {
+				throw std::system_error(make_error_code(std::errc::illegal_byte_sequence), e.what());
+			}
+			return filled;
+		}
+		buffer::owner<const std::byte> next()
+		{
+			auto slot = pool.acquire();
+			const auto filled = fill(slot.data(), slot.capacity());
+			return std::move(slot).seal(filled);
+		}
+	};
+
+	zstream::zstream(std::unique_ptr<istream<std::byte>> input, const zstream_options& options)
+	{
+		auto settings = options;
+		if(!settings.chunk_size)
+			settings.chunk_size = zstream_options().chunk_size;
+		source = std::make_unique<decoder>(std::move(input), settings);
+		if(settings.pipelined)
+			ahead = std::make_unique<prefetcher>(settings.chunk_size, settings.depth, [decoder = source.get()](std::byte* data, std::size_t size) {
+				return decoder->fill(data, size);
+			}, [decoder = source.get()] {
+				decoder->interrupt();
+			});
+	}
+
+	zstream::zstream(const std::filesystem::path& path, const zstream_options& options)
+	: zstream(ifstream(path, {ifstream_options::access::sequential}), options)
+	{}
+
+	zstream::zstream(zstream&&) noexcept = default;
+	zstream& zstream::operator=(zstream&&) noexcept = default;
+	zstream::~zstream() = default;
+
+	bool zstream::zstd_supported() noexcept
+	{
+#if defined(UTILS_STREAM_ZSTD)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	zstream_options::format zstream::format() const noexcept
+	{
+		return source ? source->format() : zstream_options::format::none;
+	}
+
+	buffer::owner<const std::byte> zstream::next() const
+	{
+		return ahead ? ahead->next() : source->next();
+	}
+
+	bool zstream::fill() const noexcept
+	{
+		if(current.empty() && source && !ended && !error) {
+			try {
+				current = next();
+				ended = current.empty();
+			} catch(...) {
+				error = std::current_exception();
+			}
+		}
+		return !current.empty() || error;
+	}
+
+	void zstream::get(utils::buffer::view<std::byte>& view)
+	{
+		std::size_t filled = 0;
+		while(filled < view.size() && (!filled || !current.empty()) && fill()) {
+			if(error)
+				std::rethrow_exception(std::exchange(error, nullptr));
+			auto chunk = current.first(view.size() - filled);
+			std::copy(chunk.begin(), chunk.end(), view.data() + filled);
+			filled += chunk.size();
+		}
+		view = view.first(filled);
+	}
+
+	utils::buffer::owner<const std::byte> zstream::get()
+	{
+		fill();
+		if(error)
+			std::rethrow_exception(std::exchange(error, nullptr));
+		return std::exchange(current, buffer::owner<const std::byte>());
+	}
+
+	void zstream::interrupt() noexcept
+	{
+		if(ahead)
+			ahead->stop();
+		else if(source)
+			source->interrupt();
+	}
+
+	void zstream::close()
+	{
+		ahead.reset();
+		source.reset();
+		current = buffer::owner<const std::byte>();
+		error = nullptr;
+	}
+
+	bool zstream::closed() const noexcept
+	{
+		return fill();
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <type_traits>
+#include <utils/stream/istream.hpp>
+
+namespace utils::stream {
+
+	struct zstream_options
+	{
+		enum class format { automatic, none, gzip, zlib, zstd };
+		format compression = format::automatic;
+		std::size_t chunk_size = 1024u * 1024u;
+		bool pipelined = false;
+		std::size_t depth = 2;
+	};
+
+	class prefetcher;
+
+	class zstream: public istream<std::byte>
+	{
+		class decoder;
+		std::unique_ptr<decoder> source;
+		std::unique_ptr<prefetcher> ahead;
+		mutable buffer::owner<const std::byte> current;
+		mutable bool ended = false;
+		mutable std::exception_ptr error;
+		bool fill() const noexcept;
+		buffer::owner<const std::byte> next() const;
+	public:
+		zstream(std::unique_ptr<istream<std::byte>> input, const zstream_options& options = {});
+		zstream(const std::filesystem::path& path, const zstream_options& options = {});
+		template<class Stream, class = std::enable_if_t<std::is_base_of_v<istream<std::byte>, std::decay_t<Stream>> && !std::is_same_v<std::decay_t<Stream>, zstream>>>
+		zstream(Stream&& input, const zstream_options& options = {})
+		: zstream(std::unique_ptr<istream<std::byte>>(std::make_unique<std::decay_t<Stream>>(std::forward<Stream>(input))), options)
+		{}
+		zstream(zstream&&) noexcept;
+		zstream& operator=(zstream&&) noexcept;
+		~zstream() override;
+	public:
+		static bool zstd_supported() noexcept;
+		zstream_options::format format() const noexcept;
+	public:
+		using value_type = utils::buffer::owner<const std::byte>;
+		void get(utils::buffer::view<std::byte>&) override;
+		utils::buffer::owner<const std::byte> get() override;
+		void interrupt() noexcept override;
+		void close() override;
+		bool closed() const noexcept override;
+	};
+
+}